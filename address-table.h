@@ -0,0 +1,218 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef ADDRESS_TABLE_H
+#define ADDRESS_TABLE_H
+
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Simulation-wide table that gives the MAC and IP addresses of each node
+ * a dense 16-bit ID (the same for both addresses of the node). It is
+ * filled at NoriaContainer::Install. When the addresses of the nodes are
+ * consecutive (Ipv4AddressHelper, Mac48Address::Allocate) the ID of an
+ * address is found by array indexing, otherwise in a hash table
+ */
+class AddressTable {
+
+   public:
+   
+   /**
+    * ID of the addresses that do not belong to any node
+    */
+   static const uint16_t INVALID_ID = 0xffff;
+   
+   /**
+    *
+    */
+   AddressTable (void);
+   
+   /**
+    * Adds the addresses of a node and returns their ID
+    */
+   uint16_t Add (Mac48Address mac, Ipv4Address ip);
+   
+   /**
+    * Builds the arrays of consecutive addresses (if they are dense enough)
+    * when nodes were added since the last build. It is done at the first
+    * lookup, or before the table is read by several threads
+    */
+   void Build (void);
+   
+   /**
+    *
+    */
+   void Clear (void);
+   
+   /**
+    *
+    */
+   uint16_t GetId (Mac48Address mac);
+   
+   /**
+    *
+    */
+   uint16_t GetId (Ipv4Address ip);
+   
+   /**
+    *
+    */
+   Ipv4Address GetIp (uint16_t id);
+   
+   /**
+    * Key of a MAC address in the hash tables
+    */
+   static uint64_t GetKey (Mac48Address mac);
+   
+   /**
+    *
+    */
+   Mac48Address GetMac (uint16_t id);
+   
+   /**
+    *
+    */
+   uint32_t GetSize (void);
+   
+   
+   private:
+   
+   /**
+    *
+    */
+   std::vector<Mac48Address> v_macs;
+   
+   /**
+    *
+    */
+   std::vector<Ipv4Address> v_ips;
+   
+   /**
+    * ID of each MAC address (key) of the nodes
+    */
+   std::unordered_map<uint64_t, uint16_t> m_macIds;
+   
+   /**
+    * ID of each IP address of the nodes
+    */
+   std::unordered_map<uint32_t, uint16_t> m_ipIds;
+   
+   /**
+    * Lowest MAC address (key) of the nodes
+    */
+   uint64_t m_macBase;
+   
+   /**
+    * ID of the MAC addresses from m_macBase on
+    */
+   std::vector<uint16_t> v_macIds;
+   
+   /**
+    * Lowest IP address of the nodes
+    */
+   uint32_t m_ipBase;
+   
+   /**
+    * ID of the IP addresses from m_ipBase on
+    */
+   std::vector<uint16_t> v_ipIds;
+   
+   /**
+    * Indicates if the arrays must be built again
+    */
+   bool m_build;
+
+};
+
+
+/**
+ * Position (in a container of an agent) of each address. The addresses
+ * with an ID in the AddressTable are kept in an array indexed by the ID,
+ * the others in a hash table
+ */
+class AddressIndex {
+
+   public:
+   
+   /**
+    * Position of the addresses that are not in the index
+    */
+   static const uint32_t NOT_FOUND = 0xffffffff;
+   
+   /**
+    *
+    */
+   AddressIndex (void);
+   
+   /**
+    *
+    */
+   void Clear (void);
+   
+   /**
+    *
+    */
+   void Erase (Mac48Address mac);
+   
+   /**
+    *
+    */
+   void Erase (Ipv4Address ip);
+   
+   /**
+    *
+    */
+   uint32_t Find (Mac48Address mac);
+   
+   /**
+    *
+    */
+   uint32_t Find (Ipv4Address ip);
+   
+   /**
+    *
+    */
+   void Set (Mac48Address mac, uint32_t position);
+   
+   /**
+    *
+    */
+   void Set (Ipv4Address ip, uint32_t position);
+   
+   
+   private:
+   
+   /**
+    *
+    */
+   void Erase (uint16_t id, uint64_t key);
+   
+   /**
+    *
+    */
+   uint32_t Find (uint16_t id, uint64_t key);
+   
+   /**
+    *
+    */
+   void Set (uint16_t id, uint64_t key, uint32_t position);
+   
+   /**
+    * Position of the addresses with ID
+    */
+   std::vector<uint32_t> v_positions;
+   
+   /**
+    * Position of the addresses without ID
+    */
+   std::unordered_map<uint64_t, uint32_t> m_others;
+
+};
+
+#endif
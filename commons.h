@@ -21,6 +21,11 @@ class Commons {
     */
    static const std::string dataRegistry;
    
+   /**
+    *
+    */
+   static const std::string filterRegistry;
+   
    /**
     *
     */
@@ -36,6 +41,11 @@ class Commons {
     */
    static const std::string noriaRegistry;
    
+   /**
+    * OLSR messages received and decoded by each Noria
+    */
+   static const std::string olsrRegistry;
+   
    /**
     *
     */
@@ -46,6 +56,11 @@ class Commons {
     */
    static const std::string receivedRegistry;
    
+   /**
+    * Executed, reused and skipped routing table recalculations of each Noria
+    */
+   static const std::string recalculationRegistry;
+   
    /**
     *
     */
@@ -66,6 +81,11 @@ class Commons {
     */
    static const std::string stateRegistry;
    
+   /**
+    *
+    */
+   static const std::string tapRegistry;
+   
    /**
     *
     */
@@ -76,11 +96,31 @@ class Commons {
     */
    static const double RESERVED_LIFETIME;
    
+   /**
+    * Time (in seconds) a decoded transmission is kept for its receivers
+    */
+   static const double FRAME_TAP_LIFETIME;
+   
+   /**
+    * Time (in seconds) a Noria remembers a destination it sent packets to
+    */
+   static const double TRANSMISSION_LIFETIME;
+   
+   /**
+    * Maximum number of destinations remembered by a Noria
+    */
+   static const uint32_t TRANSMISSION_CAPACITY;
+   
    /**
     *
     */
    static const uint16_t OLSR_PORT;
    
+   /**
+    * Number of computed routing tables a Noria keeps to reuse them
+    */
+   static const uint32_t ROUTES_CACHE_CAPACITY;
+   
 };
 
 #endif // COMMONS_H
@@ -0,0 +1,124 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef FORWARDING_TABLE_H
+#define FORWARDING_TABLE_H
+
+#include "olsr-routing-protocol.h"
+#include "routingtable-container.h"
+#include <stdint.h>
+
+using namespace ns3;
+
+/**
+ * Routing protocol added to the list routing of a node ahead of OLSR, so
+ * the packets to the hosts of the OLSR routing table are routed from a
+ * copy of olsr::RoutingProtocol::m_table kept in a RoutingTableContainer
+ * (array indexed by the ID of the node) instead of the std::map. The copy
+ * is made again each time the RoutingTableChanged trace of the protocol is
+ * fired, which both OLSR and Noria::ApplyRoutes do after changing the table.
+ * The routes are built as RouteOutput and RouteInput of OLSR build them.
+ * Everything else (packets of the node itself, local delivery, hosts out of
+ * the table and HNA networks) is left to OLSR, which is asked next
+ */
+class ForwardingTable : public Ipv4RoutingProtocol {
+
+   public:
+   
+   /**
+    *
+    */
+   static TypeId GetTypeId (void);
+   
+   /**
+    *
+    */
+   ForwardingTable (void);
+   
+   /**
+    * Copies the table of the protocol and follows its changes
+    */
+   void Install (Ptr<olsr::RoutingProtocol> olsr);
+   
+   /**
+    *
+    */
+   virtual void NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address);
+   
+   /**
+    *
+    */
+   virtual void NotifyInterfaceDown (uint32_t interface);
+   
+   /**
+    *
+    */
+   virtual void NotifyInterfaceUp (uint32_t interface);
+   
+   /**
+    *
+    */
+   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
+   
+   /**
+    * Same table as the one of OLSR
+    */
+   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const;
+   
+   /**
+    * Forwards the packets to the hosts of the table. Returns false for the
+    * others, so they are handled by OLSR
+    */
+   virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev, UnicastForwardCallback ucb, MulticastForwardCallback mcb, LocalDeliverCallback lcb, ErrorCallback ecb);
+   
+   /**
+    * Route to a host of the table, or null so OLSR is asked
+    */
+   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
+   
+   /**
+    *
+    */
+   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
+   
+   
+   private:
+   
+   /**
+    *
+    */
+   virtual void DoDispose (void);
+   
+   /**
+    * Route to the destination as built by OLSR, following the next hops as
+    * RoutingProtocol::FindSendEntry. Null if the destination is not in the
+    * table or the route is not the one OLSR would give
+    */
+   Ptr<Ipv4Route> GetRoute (Ipv4Address destination, Ptr<const NetDevice> oif);
+   
+   /**
+    * Copies the table of the protocol. Connected to RoutingTableChanged
+    */
+   void Update (uint32_t size);
+   
+   /**
+    *
+    */
+   Ptr<olsr::RoutingProtocol> m_olsr;
+   
+   /**
+    *
+    */
+   Ptr<Ipv4> m_ipv4;
+   
+   /**
+    * Copy of the hosts of m_table (the HNA routes are not copied)
+    */
+   RoutingTableContainer m_routes;
+
+};
+
+#endif
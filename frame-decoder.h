@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef FRAME_DECODER_H
+#define FRAME_DECODER_H
+
+using namespace ns3;
+
+/**
+ * Classes in which the decoder sorts the sniffed frames
+ */
+enum FrameClass {
+   FRAME_CONTROL = 0,   // ACK and other control frames
+   FRAME_MANAGEMENT,    // Management frames
+   FRAME_NON_IPV4,      // Data frames that do not carry IPv4 (ARP, Null)
+   FRAME_NON_UDP,       // IPv4 packets that do not carry UDP
+   FRAME_MALFORMED,     // Truncated or unknown headers
+   FRAME_OLSR,          // UDP datagrams to the OLSR port
+   FRAME_DATA,          // UDP datagrams of the applications
+   FRAME_CLASSES        // Number of classes
+};
+
+/**
+ * Struct where the fields of a sniffed frame used by the Noria are stored
+ */
+struct FrameInfo {
+
+   /**
+    * Source address of the frame (Addr2 of the IEEE 802.11 MAC header)
+    */
+   Mac48Address f_srcMac;
+   
+   /**
+    * Destination address of the frame (Addr1 of the IEEE 802.11 MAC header)
+    */
+   Mac48Address f_dstMac;
+   
+   /**
+    * Source address of the IPv4 header
+    */
+   Ipv4Address f_srcIp;
+   
+   /**
+    * Destination address of the IPv4 header
+    */
+   Ipv4Address f_dstIp;
+   
+   /**
+    * Destination port of the UDP header
+    */
+   uint16_t f_dstPort;
+   
+   /**
+    * Frame info creator
+    */
+   FrameInfo () : f_dstPort (0) {
+   };
+};
+
+
+/**
+ * Reads the fields of a FrameInfo directly from the bytes of a sniffed
+ * frame (WifiMac + LLC/SNAP + IPv4 + UDP), without copying the packet
+ * nor building the ns-3 header objects
+ */
+class FrameDecoder {
+
+   public:
+   
+   /**
+    * Maximum number of bytes read from the frame: WifiMac header with
+    * four addresses and QoS control, LLC/SNAP, IPv4 with options and UDP
+    */
+   static const uint32_t HEADER_BYTES = 128;
+   
+   /**
+    * Decodes the frame and returns its class. The MAC addresses of info are
+    * valid for every class but FRAME_CONTROL, the IP addresses and port
+    * only for FRAME_OLSR and FRAME_DATA. The class is taken from the type
+    * and subtype of the Frame Control field before any other header is read
+    */
+   static FrameClass Decode (Ptr<const Packet> packet, FrameInfo &info);
+   
+   /**
+    * Reads only the transmitter address (Addr2) of a data or management
+    * frame. Returns false for control frames and if the frame is too small
+    * to contain it
+    */
+   static bool DecodeTransmitter (Ptr<const Packet> packet, Mac48Address &transmitter);
+   
+   /**
+    * Name of the class (for the registry files)
+    */
+   static std::string GetClassName (FrameClass frameClass);
+   
+};
+
+
+/**
+ * Early-reject stage placed in the sniffer callbacks. It decides from the
+ * class of the frame whether the Noria must process it, and counts the
+ * accepted and rejected frames of each class
+ */
+class FrameFilter {
+
+   public:
+   
+   /**
+    *
+    */
+   FrameFilter (void);
+   
+   /**
+    * Received frames are processed if they are OLSR (relations) or data
+    */
+   bool AcceptReceived (FrameClass frameClass);
+   
+   /**
+    * Sent frames are processed only if they are data
+    */
+   bool AcceptSent (FrameClass frameClass);
+   
+   /**
+    *
+    */
+   void Clear (void);
+   
+   /**
+    * Write the counters of each class in the registry file
+    */
+   void Write (void);
+   
+   
+   private:
+   
+   /**
+    * Received frames accepted per class
+    */
+   uint64_t f_rxAccepted[FRAME_CLASSES];
+   
+   /**
+    * Received frames rejected per class
+    */
+   uint64_t f_rxRejected[FRAME_CLASSES];
+   
+   /**
+    * Sent frames accepted per class
+    */
+   uint64_t f_txAccepted[FRAME_CLASSES];
+   
+   /**
+    * Sent frames rejected per class
+    */
+   uint64_t f_txRejected[FRAME_CLASSES];
+
+};
+
+#endif
@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef FRAME_TAP_H
+#define FRAME_TAP_H
+
+#include <deque>
+#include <map>
+
+using namespace ns3;
+
+/**
+ * Struct where a decoded transmission is stored
+ */
+struct TapEntry {
+
+   /**
+    * Class of the transmitted frame
+    */
+   FrameClass t_class;
+   
+   /**
+    * Decoded fields of the transmitted frame
+    */
+   FrameInfo t_info;
+   
+   /**
+    * Time (in seconds) of the transmission
+    */
+   double t_time;
+};
+
+
+/**
+ * Decodes each transmitted frame once, when the transmitter sends it
+ * (MonitorSnifferTx), and hands the decoded summary to every receiver of
+ * the frame (MonitorSnifferRx). A transmission is identified by the uid
+ * of the packet and the address of the transmitter, since a forwarded
+ * packet keeps its uid along the path
+ */
+class FrameTap {
+
+   public:
+   
+   /**
+    *
+    */
+   FrameTap (void);
+   
+   /**
+    *
+    */
+   void Clear (void);
+   
+   /**
+    * Returns the class and summary of a frame heard by a receiver. The
+    * summary comes from the transmission, the frame is only decoded if
+    * the transmission is unknown
+    */
+   FrameClass Receive (Ptr<const Packet> packet, FrameInfo &info);
+   
+   /**
+    * Decodes a frame that is being transmitted and keeps its summary for
+    * the receivers
+    */
+   FrameClass Transmit (Ptr<const Packet> packet, FrameInfo &info);
+   
+   /**
+    * Write the counters of decoded and reused frames in the registry file
+    */
+   void Write (void);
+   
+   
+   private:
+   
+   /**
+    * Key of a transmission: uid of the packet and address of the transmitter
+    */
+   typedef std::pair<uint64_t, uint64_t> TapKey;
+   
+   /**
+    *
+    */
+   static TapKey GetKey (uint64_t uid, Mac48Address transmitter);
+   
+   /**
+    * Removes the transmissions older than Commons::FRAME_TAP_LIFETIME
+    */
+   void Expire (double now);
+   
+   /**
+    * Decoded transmissions
+    */
+   std::map<TapKey, TapEntry> m_entries;
+   
+   /**
+    * Transmissions in order of arrival, used to expire them
+    */
+   std::deque< std::pair<double, TapKey> > m_order;
+   
+   /**
+    * Frames decoded at the transmitter
+    */
+   uint64_t m_decoded;
+   
+   /**
+    * Received frames whose summary was taken from the transmission
+    */
+   uint64_t m_hits;
+   
+   /**
+    * Received frames that had to be decoded again
+    */
+   uint64_t m_misses;
+
+};
+
+#endif
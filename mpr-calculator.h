@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef MPR_CALCULATOR_H
+#define MPR_CALCULATOR_H
+
+#include "address-table.h"
+#include "olsr-routing-protocol.h"
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Computes the MPR set of a node with the same result as
+ * RoutingProtocol::MprComputation. The symmetric neighbors (N) and the
+ * 2-hop neighbors (N2) are mapped to dense positions, and the 2-hop
+ * neighbors still reachable through each neighbor are kept as a bitset:
+ * the reachability of a neighbor is the popcount of its bitset, and the
+ * providers of each 2-hop neighbor are counted a word at a time
+ */
+class MprCalculator {
+
+   public:
+   
+   /**
+    *
+    */
+   MprCalculator (void);
+   
+   /**
+    * Computes the MPR set and sets it in the OLSR state
+    */
+   void Compute (Ptr<olsr::RoutingProtocol> olsr);
+   
+   
+   private:
+   
+   /**
+    * First word of the bitset of the neighbor
+    */
+   uint64_t *GetCover (uint32_t neighbor);
+   
+   /**
+    * D(y) of the neighbor, computed by the protocol the first time it is
+    * needed in a computation
+    */
+   int GetDegree (uint32_t neighbor);
+   
+   /**
+    * Number of 2-hop neighbors still reachable through the neighbor
+    */
+   uint32_t GetReachability (uint32_t neighbor);
+   
+   /**
+    * Removes from N2 the pairs of the neighbor
+    */
+   void RemoveCover (uint32_t neighbor);
+   
+   /**
+    *
+    */
+   Ptr<olsr::RoutingProtocol> m_olsr;
+   
+   /**
+    * Symmetric neighbors (N), in the order of the neighbor set
+    */
+   std::vector<const olsr::NeighborTuple *> v_neighbors;
+   
+   /**
+    * Position of each neighbor in v_neighbors
+    */
+   AddressIndex m_neighborIndex;
+   
+   /**
+    * Position of each 2-hop neighbor of N2 in the bitsets
+    */
+   AddressIndex m_twoHopIndex;
+   
+   /**
+    * Pairs (neighbor, 2-hop neighbor) of N2
+    */
+   std::vector<std::pair<uint32_t, uint32_t> > v_pairs;
+   
+   /**
+    * Words of each bitset
+    */
+   uint32_t m_words;
+   
+   /**
+    * Bitsets of the neighbors, one after another
+    */
+   std::vector<uint64_t> v_cover;
+   
+   /**
+    * 2-hop neighbors reachable through one neighbor or more
+    */
+   std::vector<uint64_t> v_once;
+   
+   /**
+    * 2-hop neighbors reachable through two neighbors or more
+    */
+   std::vector<uint64_t> v_twice;
+   
+   /**
+    * 2-hop neighbors covered by the neighbors selected in the step 3
+    */
+   std::vector<uint64_t> v_covered;
+   
+   /**
+    * D(y) of each neighbor, -1 while it is not computed
+    */
+   std::vector<int> v_degrees;
+
+};
+
+#endif
@@ -26,27 +26,27 @@ class NoriaContainer {
    /**
     *
     */
-   NoriaContainer (void);
+   typedef std::vector< Ptr<Noria> >::const_iterator Iterator;
    
    /**
     *
     */
-   void Add (Noria noria);
+   NoriaContainer (void);
    
    /**
-    *
+    * Stops the worker threads
     */
-   void AddRelation (uint32_t index, Mac48Address mac, Ipv4Address ip);
+   ~NoriaContainer (void);
    
    /**
     *
     */
-   void AddReserved (uint32_t index, Ipv4Address ip, double time);
+   void Add (Ptr<Noria> noria);
    
    /**
     *
     */
-   void AddTransmission (uint32_t index, Ipv4Address ip, double time);
+   Iterator Begin (void) const;
    
    /**
     *
@@ -54,152 +54,256 @@ class NoriaContainer {
    void Clear (void);
    
    /**
-    *
+    * Indicates if the agents installed from now on route the packets to the
+    * hosts of the OLSR routing table with a ForwardingTable
     */
-   void EraseReservedNode (uint32_t index, uint32_t reservedIndex);
+   void DenseForwarding (bool enable);
    
    /**
     *
     */
-   void EraseTransmission (uint32_t index, Ipv4Address ip);
+   Iterator End (void) const;
    
    /**
     *
     */
-   bool ExistTransmission (uint32_t index, Ipv4Address ip);
+   void ExpireTransmissions (double time);
    
    /**
     *
     */
-   Noria Get (uint32_t i) const;
+   Ptr<Noria> Get (uint32_t i) const;
    
    /**
     *
     */
-   Ipv4Address GetRelatedIpAddress (uint32_t index, Mac48Address mac);
+   uint32_t GetSize (void) const;
    
    /**
     *
     */
-   double GetRecalculateRoutingTable (uint32_t index);
+   void Install (NodeContainer container, Ipv4InterfaceContainer interfaces);
    
    /**
-    *
+    * Indicates if the agents installed from now on receive the OLSR packets
+    * with an OlsrReceiver that decodes the messages lazily
     */
-   uint32_t GetSize (void) const;
+   void LazyOlsrDecoding (bool enable);
    
    /**
-    *
+    * Limits the destinations remembered by the agents installed from now
+    * on: time (in seconds) since their last packet and maximum number of
+    * them (0: no limit). The agents are aged every lifetime seconds
     */
-   uint32_t GetNoriaIndex (Mac48Address mac);
+   void LimitTransmissions (double lifetime, uint32_t capacity);
    
    /**
-    *
+    * Recalculates in one batch the routing tables of all the agents. The
+    * tables are computed by the worker threads and the simulator thread,
+    * and then written to OLSR in the order of the agents, so the result
+    * does not depend on the threads
     */
-   double GetRecalculateRoutingTablePeriod (uint32_t index);
+   void RecalculateRoutingTables (void);
    
    /**
-    *
+    * Indicates if the OLSR packets of the agents installed from now on are
+    * received by an OlsrReceiver
     */
-   double GetTransmissionTime (uint32_t index, Ipv4Address ip);
+   void ReceiveOlsrPackets (bool enable);
    
    /**
     *
     */
-   void Install (NodeContainer container, Ipv4InterfaceContainer interfaces);
+   void SetRecalculateRoutingTablePeriod (double period);
    
    /**
-    *
+    * Number of threads that compute the routing tables of a batch, counting
+    * the simulator thread. With 0 the tables are not recalculated in batch,
+    * each agent schedules its own
     */
-   bool IsReserved (uint32_t index);
+   void SetRecalculationThreads (uint32_t threads);
    
    /**
-    *
+    * Indicates if the agents installed from now on share the address relations
     */
-   void RecalculateRoutingTable (uint32_t index);
+   void ShareRelations (bool enable);
    
    /**
     *
     */
-   void ReceivePacketProcess (uint32_t index, Ptr<Packet> packet);
+   void ShowConfig (void);
+   
+   /**
+    * Stops and joins the worker threads. They are created again by the next
+    * batch
+    */
+   void StopWorkers (void);
    
    /**
-    *
+    * Indicates if the OlsrReceiver of the agents installed from now on fires
+    * the RxPacket trace of the protocol
     */
-   void Reserve (uint32_t index, double now, Ipv4Address srcIP, Ipv4Address dstIP);
+   void TraceOlsrPackets (bool enable);
    
    /**
     *
     */
-   void Reset (uint32_t index);
+   void UpdateReservedNodes (double time);
    
    /**
     *
     */
-   void SendPacketProcess (uint32_t index, Ptr<Packet> packet);
+   void WriteAddressRelations (bool enable);
+   
+   /**
+    * Writes the OLSR messages received and decoded by each Noria
+    */
+   void WriteOlsrMessages (void);
+   
+   /**
+    * Writes the executed and skipped recalculations of each Noria
+    */
+   void WriteRecalculations (void);
    
    /**
     *
     */
-   void SetRecalculateRoutingTablePeriod (double period);
+   void WriteReservationState (bool enable);
    
    /**
     *
     */
-   void SetRecalculateRoutingTablePeriod (uint32_t index, double period);
+   void WriteReservedNodes (bool enable);
    
    /**
     *
     */
-   void ShowConfig (void);
+   void WriteRoutingTables (bool enable);
+   
+   
+   private:
+   
+   /**
+    * Longest wait in nanoseconds of a thread for a batch to start or end.
+    * The Wait of SystemCondition loses the signals sent before it is called,
+    * so the threads check the batch again after this time
+    */
+   static const uint64_t BATCH_WAIT_NS = 1000000;
+   
+   /**
+    * Work of each thread of a batch: takes the next agent until all of them
+    * have computed their routing table
+    */
+   void ComputeRoutingTables (void);
+   
+   /**
+    * Loop of a worker thread: waits for a batch, computes its share of the
+    * routing tables and waits for the next one, until the workers are stopped
+    */
+   void RunWorker (void);
+   
+   /**
+    * Creates the worker threads the first time a batch is recalculated
+    */
+   void StartWorkers (void);
+   
+   /**
+    * The agents are created once at Install and never copied, so the
+    * callbacks and events of each agent can hold a pointer to it
+    */
+   std::vector< Ptr<Noria> > m_norias;
    
    /**
     *
     */
-   void UpdateReservedNodes (uint32_t index, double time);
+   bool m_denseForwarding;
    
    /**
     *
     */
-   void UpdateTransmissionTime (uint32_t index, Ipv4Address ip, double time);
+   bool m_lazyOlsrDecoding;
    
    /**
     *
     */
-   void WriteAddressRelations (bool enable);
+   bool m_receiveOlsr;
    
    /**
     *
     */
-   void WriteReservationState (bool enable);
+   bool m_shareRelations;
    
    /**
     *
     */
-   void WriteReservationState (uint32_t index);
+   bool m_traceOlsr;
    
    /**
     *
     */
-   void WriteReservedNodes (bool enable);
+   uint32_t m_recalculationThreads;
    
    /**
     *
     */
-   void WriteRoutingTable (uint32_t index);
+   double m_transmissionLifetime;
    
    /**
     *
     */
-   void WriteRoutingTables (bool enable);
+   uint32_t m_transmissionCapacity;
    
+   /**
+    * Simulation time of the batch being computed
+    */
+   Time m_batchTime;
    
-   private:
+   /**
+    * Next agent of the batch to compute its routing table
+    */
+   uint32_t m_batchNext;
    
    /**
-    *
+    * Indicates if each agent of the batch computed its routing table (one
+    * byte per agent, since the threads write them at the same time)
+    */
+   std::vector<uint8_t> v_batchComputed;
+   
+   /**
+    * Worker threads, created once and kept waiting between batches
+    */
+   std::vector<Ptr<SystemThread> > v_workers;
+   
+   /**
+    * Number of the current batch. A worker computes a batch when this
+    * number differs from the one of the last batch it computed
+    */
+   uint64_t m_batchNumber;
+   
+   /**
+    * Workers that did not finish the current batch
+    */
+   uint32_t m_batchWorking;
+   
+   /**
+    * Indicates if the workers must end
+    */
+   bool m_stopWorkers;
+   
+   /**
+    * Protects m_batchNext, m_batchNumber, m_batchWorking and m_stopWorkers
+    */
+   SystemMutex m_batchMutex;
+   
+   /**
+    * Signaled when a batch starts or the workers are stopped
+    */
+   SystemCondition m_batchStart;
+   
+   /**
+    * Signaled when the last worker finishes a batch
     */
-   std::vector<Noria> m_norias;
+   SystemCondition m_batchDone;
 
 };
 
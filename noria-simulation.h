@@ -54,7 +54,7 @@ class NoriaSimulation {
    /**
     *
     */
-   void SetParameters (double height, double width, uint32_t nodes, uint32_t sinks, bool norias, double recalculateTime, double time, bool mobility, bool addressRelations, bool asciiFiles, bool mobilityFiles, bool pcapFiles, bool reservationState, bool reservedNodes, bool routingTables);
+   void SetParameters (double height, double width, uint32_t nodes, uint32_t sinks, bool norias, double recalculateTime, double time, bool mobility, bool addressRelations, bool asciiFiles, bool mobilityFiles, bool pcapFiles, bool reservationState, bool reservedNodes, bool routingTables, bool sharedRelations, uint32_t threads, double minInterval, bool receiveOlsr, bool lazyOlsr, bool rxTrace, bool denseTable, double lifetime, uint32_t capacity);
    
    /**
     *
@@ -84,11 +84,27 @@ class NoriaSimulation {
     */
    std::string dataRate;
    
+   /**
+    *   Indica si los Noria enrutan los paquetes con la copia densa de la tabla de OLSR
+    */
+   bool denseForwarding;
+   
    /**
     *
     */
    bool installNorias;
    
+   /**
+    *   Indica si los Noria decodifican solo los mensajes OLSR que procesan o reenvian
+    */
+   bool lazyOlsrDecoding;
+   
+   /**
+    *   Tiempo minimo entre los recalculos de un Noria solicitados por reservas
+    *   (En segundos)
+    */
+   double minRecalculationInterval;
+   
    /**
     *   Transmission power
     */
@@ -114,6 +130,16 @@ class NoriaSimulation {
     */
    uint32_t nSinks;
    
+   /**
+    *   Indica si los paquetes OLSR son recibidos por los Noria
+    */
+   bool olsrReceiver;
+   
+   /**
+    *   Indica si los Noria disparan la traza Rx de OLSR con los mensajes recibidos
+    */
+   bool olsrRxTrace;
+   
    /**
     *   Total de paquetes recibidos
     */
@@ -135,6 +161,17 @@ class NoriaSimulation {
     */
    double recalculatePeriod;
    
+   /**
+    *   Numero de hilos que recalculan en lote las tablas de enrutamiento
+    *   (0: cada Noria recalcula su tabla en su propio evento)
+    */
+   uint32_t recalculationThreads;
+   
+   /**
+    *   Indica si los Noria comparten las relaciones de direcciones de los nodos
+    */
+   bool shareRelations;
+   
    /**
     *   Total simulation time (in seconds)
     */
@@ -145,6 +182,17 @@ class NoriaSimulation {
     */
    bool traceMobility;
    
+   /**
+    *   Numero maximo de destinos recordados por cada Noria (0: sin limite)
+    */
+   uint32_t transmissionCapacity;
+   
+   /**
+    *   Tiempo que un Noria recuerda un destino desde su ultimo paquete
+    *   (En segundos, 0: sin limite)
+    */
+   double transmissionLifetime;
+   
    /**
     *
     */
@@ -11,19 +11,28 @@
 #include "ns3/network-module.h"
 #include "ns3/wifi-module.h"
 #include "ns3/ipv4-l3-protocol.h"
+#include "address-table.h"
+#include "frame-decoder.h"
+#include "frame-tap.h"
 #include "relation-container.h"
 #include "reserved-container.h"
 #include "transmissioninfo-container.h"
+#include "olsr-receiver.h"
 #include "olsr-routing-protocol.h"
+#include "olsrstate-index.h"
+#include "routingtable-container.h"
+#include "forwarding-table.h"
 #include <stdint.h>
+#include <deque>
 #include <vector>
 
 using namespace ns3;
 
 /**
- *
+ * Reference counted so that the container, the sniffer callbacks and the
+ * scheduled events share the same agent instead of copies of it
  */
-class Noria {
+class Noria : public SimpleRefCount<Noria> {
 
    public:
    
@@ -47,6 +56,27 @@ class Noria {
     */
    void AddTransmission (Ipv4Address ip, double time);
    
+   /**
+    * Writes to OLSR the routes of the last computed routing table. Must be
+    * called from the simulator thread
+    */
+   void ApplyRoutes (void);
+   
+   /**
+    * Computes the routing table apart, without writing it to OLSR, and
+    * returns false if the recalculation was skipped. It only reads the OLSR
+    * state and the reserved nodes of this agent, so the tables of several
+    * agents can be computed at the same time by different threads
+    */
+   bool ComputeRoutingTable (Time now);
+   
+   /**
+    * Indicates if the packets to the hosts of the OLSR routing table are
+    * routed by a ForwardingTable instead of by OLSR. Must be set before
+    * Install
+    */
+   void DenseForwarding (bool enable);
+   
    /**
     *
     */
@@ -62,6 +92,17 @@ class Noria {
     */
    bool ExistTransmission (Ipv4Address ip);
    
+   /**
+    * Resets the reservation info when the lifetime of the oldest pending
+    * reservation ends
+    */
+   void ExpireReservation (void);
+   
+   /**
+    *
+    */
+   void ExpireTransmissions (double time);
+   
    /**
     *
     */
@@ -72,11 +113,26 @@ class Noria {
     */
    Ipv4Address GetIpAddress (void);
    
+   /**
+    *
+    */
+   double GetLastRecalculation (void);
+   
    /**
     *
     */
    Mac48Address GetMacAddress (void);
    
+   /**
+    *
+    */
+   const OlsrReceiver &GetOlsrReceiver (void);
+   
+   /**
+    *
+    */
+   uint32_t GetRecalculations (void);
+   
    /**
     *
     */
@@ -87,6 +143,11 @@ class Noria {
     */
    Ipv4Address GetRelatedIpAddress (Mac48Address mac);
    
+   /**
+    *
+    */
+   uint32_t GetReusedRecalculations (void);
+   
    /**
     *
     */
@@ -100,17 +161,49 @@ class Noria {
    /**
     *
     */
-   bool IsReserved (void);
+   uint32_t GetSkippedRecalculations (void);
    
    /**
     *
     */
+   bool IsReserved (void);
+   
+   /**
+    * Indicates if the OLSR packets of the node are received by an
+    * OlsrReceiver which decodes only the messages it processes or
+    * retransmits. Must be set before Install
+    */
+   void LazyOlsrDecoding (bool enable);
+   
+   /**
+    * Time (in seconds) a destination is remembered since its last packet and
+    * maximum number of destinations remembered (0: no limit)
+    */
+   void LimitTransmissions (double lifetime, uint32_t capacity);
+   
+   /**
+    * Called when the OLSR routing table changes. If OLSR computed it, the
+    * reserved nodes were not excluded from the table
+    */
+   void NotifyRoutingTableChanged (void);
+   
+   /**
+    * The recalculation is skipped when neither the OLSR state nor the
+    * reserved nodes changed since the last one, and the table still is
+    * the one computed by the Noria (neither overwritten by OLSR nor repaired)
+    */
    void RecalculateRoutingTable (void);
    
+   /**
+    * Indicates if the OLSR packets of the node are received by an
+    * OlsrReceiver instead of the protocol. Must be set before Install
+    */
+   void ReceiveOlsrPackets (bool enable);
+   
    /**
     *
     */
-   void ReceivePacketProcess (Ptr<Packet> packet);
+   void ReceivePacketProcess (const FrameInfo &frame);
    
    /**
     *
@@ -130,13 +223,19 @@ class Noria {
    /**
     *
     */
-   void SendPacketProcess (Ptr<Packet> packet);
+   void SendPacketProcess (const FrameInfo &frame);
    
    /**
-    *
+    * The recalculations are scheduled by the RecalculationScheduler
     */
    void SetRecalculateRoutingTablePeriod (double period);
    
+   /**
+    * Indicates if the relations between the addresses of a same node are
+    * shared with the other agents instead of copied
+    */
+   void ShareRelations (bool enable);
+   
    /**
     *
     */
@@ -147,6 +246,13 @@ class Noria {
     */
    void ShowRelations (void);
    
+   /**
+    * Indicates if the OlsrReceiver fires the RxPacket trace of the protocol.
+    * Lazy decoding is only used while the trace is disabled. Must be set
+    * before Install
+    */
+   void TraceOlsrPackets (bool enable);
+   
    /**
     *
     */
@@ -210,6 +316,83 @@ class Noria {
    
    private:
    
+   /**
+    *
+    */
+   void AddAssociationRoutes (void);
+   
+   /**
+    *
+    */
+   void AddIfaceAssocRoutes (void);
+   
+   /**
+    *
+    */
+   bool CanPatchRoutes (void);
+   
+   /**
+    *
+    */
+   void GetNextHopRoutes (Ipv4Address nextAddr, std::vector<RoutingTableEntry> &routes);
+   
+   /**
+    * Snapshot of the OLSR sets read by RecalculateRoutingTable
+    */
+   StateSnapshot GetStateSnapshot (Time now);
+   
+   /**
+    *
+    */
+   void IndexNextHops (void);
+   
+   /**
+    *
+    */
+   bool IsTwoHopCandidate (const TwoHopNeighborTuple &tuple);
+   
+   /**
+    *
+    */
+   static uint64_t Mix (uint64_t hash, uint64_t value);
+   
+   /**
+    * Repairs the routes after the IP address left the reserved nodes
+    */
+   void ReleaseReservedRoutes (Ipv4Address ip);
+   
+   /**
+    * Asks the RecalculationScheduler for a recalculation of the routing table
+    */
+   void RequestRecalculation (void);
+   
+   /**
+    * Repairs the routes after the IP address entered the reserved nodes
+    */
+   void RestrictReservedRoutes (Ipv4Address ip);
+   
+   /**
+    * Takes from the cache the routing table computed from the same state, if
+    * there is one. The reserved addresses are compared only when the
+    * fingerprints match
+    */
+   bool RestoreRoutes (const StateSnapshot &snapshot, uint64_t fingerprint, const std::vector<uint32_t> &reserved);
+   
+   /**
+    *
+    */
+   void RouteLostDestinations (const std::vector<Ipv4Address> &lost);
+   
+   /**
+    * Adds the route to the OLSR routing table and to the next hop index
+    */
+   void SetRoute (Ipv4Address dest, Ipv4Address next, uint32_t interface, uint32_t distance);
+   
+   /**
+    * Keeps the computed routing table in the cache
+    */
+   void StoreRoutes (const StateSnapshot &snapshot, uint64_t fingerprint, const std::vector<uint32_t> &reserved);
+   
    /**
     *
     */
@@ -220,6 +403,11 @@ class Noria {
     */
    Ptr<WifiNetDevice> n_netDevice;
    
+   /**
+    * MAC address of the net device, cached at Install
+    */
+   Mac48Address n_macAddress;
+   
    /**
     *
     */
@@ -230,6 +418,36 @@ class Noria {
     */
    Ptr<olsr::RoutingProtocol> n_olsr;
    
+   /**
+    * Indicates if the packets are routed by n_forwardingTable
+    */
+   bool n_denseForwarding;
+   
+   /**
+    * Copy of the OLSR routing table, ahead of OLSR in the list routing
+    */
+   Ptr<ForwardingTable> n_forwardingTable;
+   
+   /**
+    * Indicates if n_olsrReceiver decodes the OLSR messages lazily
+    */
+   bool n_lazyOlsrDecoding;
+   
+   /**
+    *
+    */
+   OlsrReceiver n_olsrReceiver;
+   
+   /**
+    * Indicates if the OLSR packets are received by n_olsrReceiver
+    */
+   bool n_receiveOlsr;
+   
+   /**
+    * Indicates if n_olsrReceiver fires the RxPacket trace
+    */
+   bool n_traceOlsr;
+   
    /**
     *
     */
@@ -240,6 +458,11 @@ class Noria {
     */
    double n_reservedTime;
    
+   /**
+    * Times of the pending resets of the reservation info, one per reservation
+    */
+   std::deque<Time> n_resetTimes;
+   
    /**
     *
     */
@@ -265,6 +488,16 @@ class Noria {
     */
    ReservedContainer n_reservednodes;
    
+   /**
+    * Indexes of the OLSR state of the last recalculation
+    */
+   OlsrStateIndex n_stateIndex;
+   
+   /**
+    * Routing table computed by the Noria, applied to the OLSR routing table
+    */
+   RoutingTableContainer n_routes;
+   
    /**
     *
     */
@@ -289,6 +522,97 @@ class Noria {
     *
     */
    bool n_writeRoutingTable;
+   
+   /**
+    * Indicates if the routing table was computed at least once by the Noria
+    */
+   bool n_computed;
+   
+   /**
+    * Indicates if the routing table was repaired after the last recalculation.
+    * A repair keeps the routes it does not need to change, where the full
+    * calculation may choose another route of the same distance, so the
+    * next recalculation is not skipped
+    */
+   bool n_routesPatched;
+   
+   /**
+    * Indicates if OLSR recomputed the routing table after the Noria did
+    */
+   bool n_tableOverwritten;
+   
+   /**
+    * Snapshot of the OLSR state at the last recalculation
+    */
+   StateSnapshot n_stateSnapshot;
+   
+   /**
+    * Fingerprint of the reserved nodes at the last recalculation
+    */
+   uint64_t n_reservedFingerprint;
+   
+   /**
+    * Reserved IP addresses at the last recalculation, sorted
+    */
+   std::vector<uint32_t> n_reservedAddresses;
+   
+   /**
+    *
+    */
+   uint32_t n_recalculations;
+   
+   /**
+    *
+    */
+   uint32_t n_skippedRecalculations;
+   
+   /**
+    * Recalculations answered with a routing table of the cache
+    */
+   uint32_t n_reusedRecalculations;
+   
+   /**
+    * Last computed routing tables, the most recently used first
+    */
+   std::deque<ComputedRoutes> n_routesCache;
+   
+   /**
+    * Time (in seconds) of the last executed recalculation
+    */
+   double n_lastRecalculation;
+   
+   /**
+    * Indicates if a recalculation was requested and is still waiting, so
+    * the routing table cannot be repaired
+    */
+   bool n_recalculationPending;
+   
+   /**
+    * Destinations routed through each next hop. It may hold routes that
+    * changed afterwards, see GetNextHopRoutes
+    */
+   std::unordered_map<uint32_t, std::vector<Ipv4Address> > n_nextHopRoutes;
+   
+   /**
+    * Valid links of each neighbor, scratch buffer of the recalculation kept
+    * (as the ones below) to reuse its memory
+    */
+   AddressBuckets n_neighborLinks;
+   
+   /**
+    * Routes of distance h of the topology expansion
+    */
+   std::vector<RoutingTableEntry> n_frontier;
+   
+   /**
+    * Routes of distance h + 1 of the topology expansion
+    */
+   std::vector<RoutingTableEntry> n_nextFrontier;
+   
+   /**
+    * Topology tuples of a level of the expansion, with the route of their T_last_addr
+    */
+   std::vector<std::pair<uint32_t, uint32_t> > n_candidates;
 
 };
 
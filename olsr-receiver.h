@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef OLSR_RECEIVER_H
+#define OLSR_RECEIVER_H
+
+#include "mpr-calculator.h"
+#include "olsr-routing-protocol.h"
+#include "olsrtuple-index.h"
+#include "tuple-sweeper.h"
+#include <stdint.h>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Receives the OLSR packets of a node in place of RoutingProtocol::RecvOlsr.
+ * The packets are processed as RecvOlsr does, message by message, except
+ * that the MPR set is computed by a MprCalculator, both after each HELLO
+ * message and after the loss of a neighbor found by the TupleSweeper.
+ * The steps of the protocol that add tuples (link sensing, 2-hop neighbors,
+ * MPR selectors, TC, MID and HNA messages and forwarding) are done by the
+ * receiver, so the expiration of the tuples it adds is checked by a
+ * TupleSweeper instead of one timer event per tuple. The neighbor set,
+ * which has no timer, is populated by the protocol. The duplicate set,
+ * checked for each received message, and the topology set, updated by the
+ * TC messages, are looked up through an OlsrTupleIndex.
+ * The messages are decoded by the receiver itself into a MessageList and a
+ * buffer kept between packets, so once their memory has grown the decoding
+ * does not allocate. The messages of unknown type are not decoded: they are
+ * only forwarded as RecvOlsr does, copying their bytes, and they are left
+ * out of the MessageList of the RxPacket trace.
+ * With lazy decoding only the fixed header of each message (type,
+ * originator, TTL, sequence number and size) is read first. The duplicate
+ * set is checked with it, and the body is decoded only when the message is
+ * processed or retransmitted; the other messages are skipped without
+ * decoding them. Since the RxPacket trace needs all the messages decoded,
+ * lazy decoding is only used while the trace is disabled
+ */
+class OlsrReceiver {
+
+   public:
+   
+   /**
+    *
+    */
+   OlsrReceiver (void);
+   
+   /**
+    * Messages whose body was decoded
+    */
+   uint64_t GetDecodedMessages (void) const;
+   
+   /**
+    * Messages received
+    */
+   uint64_t GetMessages (void) const;
+   
+   /**
+    *
+    */
+   const TupleSweeper &GetSweeper (void) const;
+   
+   /**
+    * Replaces the receive callback of the OLSR sockets. The sockets are
+    * created when the protocol starts, so they are taken by an event
+    * scheduled at the start of the simulation
+    */
+   void Install (Ptr<olsr::RoutingProtocol> olsr);
+   
+   /**
+    * Indicates if the bodies of the messages are decoded only when the
+    * messages are processed or retransmitted
+    */
+   void LazyDecoding (bool enable);
+   
+   /**
+    * Indicates if the RxPacket trace of the protocol is fired (enabled by
+    * default)
+    */
+   void TracePackets (bool enable);
+   
+   
+   private:
+   
+   /**
+    * Size in bytes of the fixed header of an OLSR message
+    */
+   static const uint32_t MESSAGE_HEADER_BYTES = 12;
+   
+   /**
+    * Size in bytes of the header of an OLSR packet
+    */
+   static const uint32_t PACKET_HEADER_BYTES = 4;
+   
+   /**
+    * Hooks the sockets created after the last check. Connected to the
+    * TxPacket trace, since the protocol sends before its sockets receive
+    */
+   void CheckSockets (const olsr::PacketHeader &header, const olsr::MessageList &messages);
+   
+   /**
+    * Decodes a message of the buffer. Returns false if the message is
+    * malformed or of unknown type
+    */
+   bool Decode (const uint8_t *data, uint32_t size, olsr::MessageHeader &message);
+   
+   /**
+    * Decodes the body of a HELLO message
+    */
+   bool DecodeHello (const uint8_t *body, uint32_t size, olsr::MessageHeader::Hello &hello);
+   
+   /**
+    * Records a message in the duplicate set and returns true if the caller
+    * must retransmit it. Only the fixed header of the message is needed
+    */
+   bool Forward (const Ipv4Address &originator, uint16_t sequenceNumber, uint8_t ttl, olsr::DuplicateTuple *duplicated, const Ipv4Address &receiverIface, const Ipv4Address &senderIface);
+   
+   /**
+    * Delay of a retransmitted message, as the JITTER of the protocol
+    */
+   Time GetJitter (void);
+   
+   /**
+    * Sets the receive callback on each socket of the protocol
+    */
+   void Hook (void);
+   
+   /**
+    *
+    */
+   static bool IsKnown (uint8_t type);
+   
+   /**
+    * Same as RoutingProtocol::LinkSensing
+    */
+   void LinkSensing (const olsr::MessageHeader &message, const olsr::MessageHeader::Hello &hello, const Ipv4Address &receiverIface, const Ipv4Address &senderIface);
+   
+   /**
+    * Same as RoutingProtocol::NeighborLoss, with the MPR set computed by
+    * the MprCalculator
+    */
+   void NeighborLoss (const olsr::LinkTuple &tuple);
+   
+   /**
+    * Same as RoutingProtocol::PopulateMprSelectorSet
+    */
+   void PopulateMprSelectorSet (const olsr::MessageHeader &message, const olsr::MessageHeader::Hello &hello);
+   
+   /**
+    * Same as RoutingProtocol::PopulateTwoHopNeighborSet
+    */
+   void PopulateTwoHopNeighborSet (const olsr::MessageHeader &message, const olsr::MessageHeader::Hello &hello);
+   
+   /**
+    * Processes a HELLO message
+    */
+   void ProcessHello (const olsr::MessageHeader &message, const Ipv4Address &receiverIface, const Ipv4Address &senderIface);
+   
+   /**
+    * Processes a HNA message
+    */
+   void ProcessHna (const olsr::MessageHeader &message, const Ipv4Address &senderIface);
+   
+   /**
+    * Processes the messages of the buffer as RecvOlsr, decoding all of them
+    * into v_messages
+    */
+   void ProcessMessages (uint32_t length, const Ipv4Address &receiverIface, const Ipv4Address &senderIface);
+   
+   /**
+    * Processes the messages of the buffer as RecvOlsr, decoding into
+    * m_message only the messages processed or retransmitted
+    */
+   void ProcessMessagesLazily (uint32_t length, const Ipv4Address &receiverIface, const Ipv4Address &senderIface);
+   
+   /**
+    * Processes a MID message
+    */
+   void ProcessMid (const olsr::MessageHeader &message, const Ipv4Address &senderIface);
+   
+   /**
+    * Processes a TC message
+    */
+   void ProcessTc (const olsr::MessageHeader &message, const Ipv4Address &senderIface);
+   
+   /**
+    * Processes a message of unknown type, which is only forwarded
+    */
+   void ProcessUnknown (uint8_t *data, uint32_t size, const Ipv4Address &receiverIface, const Ipv4Address &senderIface);
+   
+   /**
+    *
+    */
+   static void ReadAddresses (const uint8_t *data, uint32_t count, std::vector<Ipv4Address> &addresses);
+   
+   /**
+    * Reads a 16-bit value in network order
+    */
+   static uint16_t ReadU16 (const uint8_t *data);
+   
+   /**
+    * Reads a 32-bit value in network order
+    */
+   static uint32_t ReadU32 (const uint8_t *data);
+   
+   /**
+    *
+    */
+   void Receive (Ptr<Socket> socket);
+   
+   /**
+    * Changes the number of link messages of a HELLO message, reusing the
+    * address vectors of the link messages
+    */
+   void ResizeLinkMessages (std::vector<olsr::MessageHeader::Hello::LinkMessage> &linkMessages, uint32_t size);
+   
+   /**
+    * Changes the number of decoded messages, reusing the bodies of the
+    * messages
+    */
+   void ResizeMessages (uint32_t size);
+   
+   /**
+    * Queues a decoded message to be retransmitted. The TTL and hop count
+    * are changed in the message itself, which is not read again
+    */
+   void Retransmit (olsr::MessageHeader &message);
+   
+   /**
+    * Sends a message of unknown type, from its bytes in the buffer
+    */
+   void RetransmitUnknown (uint8_t *data, uint32_t size);
+   
+   /**
+    * Exchanges the bodies of two messages, of any type
+    */
+   static void SwapBodies (olsr::MessageHeader &first, olsr::MessageHeader &second);
+   
+   /**
+    *
+    */
+   Ptr<olsr::RoutingProtocol> m_olsr;
+   
+   /**
+    *
+    */
+   bool m_lazyDecoding;
+   
+   /**
+    *
+    */
+   bool m_tracePackets;
+   
+   /**
+    * Sockets of the protocol at the last check
+    */
+   uint32_t m_hookedSockets;
+   
+   /**
+    *
+    */
+   uint64_t m_messages;
+   
+   /**
+    *
+    */
+   uint64_t m_decodedMessages;
+   
+   /**
+    * Copy of the packet being received
+    */
+   std::vector<uint8_t> v_buffer;
+   
+   /**
+    * Header of the packet being received
+    */
+   olsr::PacketHeader m_packetHeader;
+   
+   /**
+    * Messages of the packet being received. Their bodies keep their memory
+    * between packets
+    */
+   olsr::MessageList v_messages;
+   
+   /**
+    * Messages removed from v_messages, kept for their bodies
+    */
+   olsr::MessageList v_spareMessages;
+   
+   /**
+    * Offset in the buffer of each message of v_messages and of each message
+    * of unknown type, in the order of the packet
+    */
+   std::vector<uint32_t> v_offsets;
+   
+   /**
+    * Last message decoded with lazy decoding. Its bodies keep their memory
+    * between messages
+    */
+   olsr::MessageHeader m_message;
+   
+   /**
+    * Address vectors of the link messages removed from the HELLO messages
+    */
+   std::vector<std::vector<Ipv4Address> > v_spareAddresses;
+   
+   /**
+    *
+    */
+   MprCalculator m_mprCalculator;
+   
+   /**
+    *
+    */
+   OlsrTupleIndex m_tupleIndex;
+   
+   /**
+    *
+    */
+   TupleSweeper m_sweeper;
+
+};
+
+#endif
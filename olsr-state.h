@@ -106,6 +106,10 @@ public:
   MprSet GetMprSet () const;
 
   // Duplicate
+  DuplicateSet & GetDuplicateSet ()
+  {
+    return m_duplicateSet;
+  }
   DuplicateTuple* FindDuplicateTuple (const Ipv4Address &address,
                                       uint16_t sequenceNumber);
   void EraseDuplicateTuple (const DuplicateTuple &tuple);
@@ -126,6 +130,10 @@ public:
   {
     return m_topologySet;
   }
+  TopologySet & GetTopologySet ()
+  {
+    return m_topologySet;
+  }
   TopologyTuple* FindTopologyTuple (const Ipv4Address &destAddr,
                                     const Ipv4Address &lastAddr);
   TopologyTuple* FindNewerTopologyTuple (const Ipv4Address &lastAddr,
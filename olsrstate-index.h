@@ -0,0 +1,230 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef OLSRSTATE_INDEX_H
+#define OLSRSTATE_INDEX_H
+
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Snapshot of the OLSR sets read by the routing table calculation, taken
+ * with a full pass over the sets at each recalculation (the changes of the
+ * sets are not tracked). It keeps a hash of their tuples, the exact number
+ * of tuples of each set, and the sorted keys of the valid links and of the
+ * topology tuples. Two snapshots are only equal if all of them are, so the
+ * links and the topology are compared exactly, and the other sets by their
+ * hash and counts
+ */
+struct StateSnapshot {
+
+   /**
+    * Counts kept in s_counts: links, valid links, neighbors, symmetric
+    * neighbors, 2-hop neighbors, topology tuples, interface associations,
+    * association tuples and local associations
+    */
+   static const uint32_t COUNTS = 9;
+   
+   /**
+    * Hash of the tuples of the sets
+    */
+   uint64_t s_hash;
+   
+   /**
+    *
+    */
+   uint32_t s_counts[COUNTS];
+   
+   /**
+    * Local and neighbor interface addresses of the valid links, sorted
+    */
+   std::vector<uint64_t> s_links;
+   
+   /**
+    * T_dest_addr and T_last_addr of the topology tuples, sorted
+    */
+   std::vector<uint64_t> s_topology;
+   
+   /**
+    * Snapshot creator (of an empty state)
+    */
+   StateSnapshot () : s_hash (0) {
+      for (uint32_t i = 0; i < COUNTS; i++) {
+         s_counts[i] = 0;
+      }
+   };
+   
+   /**
+    * The keys are only compared when the hash and the counts are equal
+    */
+   bool operator== (const StateSnapshot &snapshot) const {
+      if (s_hash != snapshot.s_hash) {
+         return false;
+      }
+      for (uint32_t i = 0; i < COUNTS; i++) {
+         if (s_counts[i] != snapshot.s_counts[i]) {
+            return false;
+         }
+      }
+      return s_links == snapshot.s_links && s_topology == snapshot.s_topology;
+   };
+};
+
+
+/**
+ * Positions of the tuples of a set grouped by an address of the tuple, in
+ * the order of the set. The vectors of the buckets are kept between builds
+ * so their memory is reused
+ */
+class AddressBuckets {
+
+   public:
+   
+   /**
+    *
+    */
+   AddressBuckets (void);
+   
+   /**
+    * Appends the position to the bucket of the address
+    */
+   void Add (Ipv4Address address, uint32_t position);
+   
+   /**
+    * Empties the buckets
+    */
+   void Clear (void);
+   
+   /**
+    * Positions of the tuples with the address (empty if there is none)
+    */
+   const std::vector<uint32_t> &Get (Ipv4Address address);
+   
+   
+   private:
+   
+   /**
+    * Bucket of each address
+    */
+   AddressIndex m_index;
+   
+   /**
+    * The first m_size buckets are in use
+    */
+   std::vector<std::vector<uint32_t> > v_buckets;
+   
+   /**
+    *
+    */
+   uint32_t m_size;
+   
+   /**
+    * Bucket of the addresses without tuples
+    */
+   static const std::vector<uint32_t> EMPTY;
+
+};
+
+
+/**
+ * Hash indexes over the OLSR state of an agent, for the lookups done by the
+ * routing table calculation (FindSymNeighborTuple, FindIfaceAssocTuple and
+ * the search of a willing neighbor), which in OlsrState scan the sets. It
+ * is built from the state at each recalculation, and it is valid while the
+ * snapshot of the state does not change. It also groups the topology tuples
+ * by T_last_addr and by T_dest_addr, so the expansion of the routes does
+ * not scan the whole TopologySet
+ */
+class OlsrStateIndex {
+
+   public:
+   
+   /**
+    *
+    */
+   OlsrStateIndex (void);
+   
+   /**
+    * Builds the indexes, unless they already are from the state with the snapshot
+    */
+   void Build (const OlsrState &state, const StateSnapshot &snapshot);
+   
+   /**
+    * Positions in the TopologySet of the tuples with the T_dest_addr
+    */
+   const std::vector<uint32_t> &GetDestAddrTuples (Ipv4Address destAddr);
+   
+   /**
+    * Positions in the TopologySet of the tuples with the T_last_addr
+    */
+   const std::vector<uint32_t> &GetLastAddrTuples (Ipv4Address lastAddr);
+   
+   /**
+    * Main address of the node with the interface address (the same address
+    * if it is not in the interface association set)
+    */
+   Ipv4Address GetMainAddress (Ipv4Address ifaceAddr);
+   
+   /**
+    * Indicates if there is a symmetric neighbor with the main address
+    */
+   bool IsSymNeighbor (Ipv4Address mainAddr);
+   
+   /**
+    * Indicates if there is a neighbor with the main address and willingness
+    * different of WILL_NEVER
+    */
+   bool IsWillingNeighbor (Ipv4Address mainAddr);
+   
+   
+   private:
+   
+   /**
+    * Flags of a neighbor in m_neighbors
+    */
+   static const uint32_t SYM_NEIGHBOR = 1;
+   
+   /**
+    *
+    */
+   static const uint32_t WILLING_NEIGHBOR = 2;
+   
+   /**
+    * Flags of each neighbor main address
+    */
+   AddressIndex m_neighbors;
+   
+   /**
+    * Main address of each interface address of the interface association set
+    */
+   std::unordered_map<uint32_t, Ipv4Address> m_mainAddresses;
+   
+   /**
+    *
+    */
+   AddressBuckets m_lastAddrTuples;
+   
+   /**
+    *
+    */
+   AddressBuckets m_destAddrTuples;
+   
+   /**
+    * Indicates if the indexes were built
+    */
+   bool m_built;
+   
+   /**
+    * Snapshot of the state of the last build
+    */
+   StateSnapshot m_snapshot;
+
+};
+
+#endif
+
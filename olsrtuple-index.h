@@ -0,0 +1,151 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef OLSRTUPLE_INDEX_H
+#define OLSRTUPLE_INDEX_H
+
+#include "olsr-routing-protocol.h"
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Index of the duplicate and topology sets of a node, used by the
+ * OlsrReceiver and its TupleSweeper in place of the lookups of OlsrState,
+ * which scan the set: FindDuplicateTuple once per received message, and
+ * FindNewerTopologyTuple, EraseOlderTopologyTuples and FindTopologyTuple
+ * (once per advertised neighbor) for each TC message.
+ * Each set is a vector whose tuples are appended, so a tuple only moves
+ * towards the start of the set (when a tuple before it is erased). The
+ * index keeps the last known position of each tuple and looks for it from
+ * there back to the start of the set. The topology tuples are also grouped
+ * by T_last_addr, so the tuples of an originator are found without
+ * scanning the set.
+ * The tuples are added and removed through the index; if the size of a
+ * set is not the expected one, the set was changed by the protocol and its
+ * index is built again from it
+ */
+class OlsrTupleIndex {
+
+   public:
+   
+   /**
+    *
+    */
+   OlsrTupleIndex (void);
+   
+   /**
+    * Same as RoutingProtocol::AddDuplicateTuple
+    */
+   void AddDuplicateTuple (const olsr::DuplicateTuple &tuple);
+   
+   /**
+    * Same as RoutingProtocol::AddTopologyTuple
+    */
+   void AddTopologyTuple (const olsr::TopologyTuple &tuple);
+   
+   /**
+    * Same as OlsrState::EraseOlderTopologyTuples, which is only called if
+    * the originator has an older tuple
+    */
+   void EraseOlderTopologyTuples (const Ipv4Address &lastAddr, uint16_t ansn);
+   
+   /**
+    * Same result as OlsrState::FindDuplicateTuple
+    */
+   olsr::DuplicateTuple *FindDuplicateTuple (const Ipv4Address &address, uint16_t sequenceNumber);
+   
+   /**
+    * A tuple of the originator newer than the ANSN, or NULL if it has
+    * none (as OlsrState::FindNewerTopologyTuple, though not always the
+    * first of the set)
+    */
+   olsr::TopologyTuple *FindNewerTopologyTuple (const Ipv4Address &lastAddr, uint16_t ansn);
+   
+   /**
+    * Same result as OlsrState::FindTopologyTuple
+    */
+   olsr::TopologyTuple *FindTopologyTuple (const Ipv4Address &destAddr, const Ipv4Address &lastAddr);
+   
+   /**
+    *
+    */
+   void Install (Ptr<olsr::RoutingProtocol> olsr);
+   
+   /**
+    * Same as RoutingProtocol::RemoveDuplicateTuple
+    */
+   void RemoveDuplicateTuple (const olsr::DuplicateTuple &tuple);
+   
+   /**
+    * Same as RoutingProtocol::RemoveTopologyTuple
+    */
+   void RemoveTopologyTuple (const olsr::TopologyTuple &tuple);
+   
+   
+   private:
+   
+   /**
+    * Builds the index again if the sets were changed apart from it
+    */
+   void Check (void);
+   
+   /**
+    * D_addr and D_seq_num of a duplicate tuple
+    */
+   static uint64_t GetKey (const Ipv4Address &address, uint16_t sequenceNumber);
+   
+   /**
+    * T_dest_addr and T_last_addr of a topology tuple
+    */
+   static uint64_t GetKey (const Ipv4Address &destAddr, const Ipv4Address &lastAddr);
+   
+   /**
+    * Topology tuple found from its last known position, or NULL
+    */
+   olsr::TopologyTuple *Locate (const Ipv4Address &destAddr, const Ipv4Address &lastAddr);
+   
+   /**
+    * Removes the topology tuple from the index, once erased from the set
+    */
+   void Unindex (const Ipv4Address &destAddr, const Ipv4Address &lastAddr);
+   
+   /**
+    *
+    */
+   Ptr<olsr::RoutingProtocol> m_olsr;
+   
+   /**
+    * Last known position of each duplicate tuple
+    */
+   std::unordered_map<uint64_t, uint32_t> m_duplicates;
+   
+   /**
+    * Expected size of the duplicate set
+    */
+   uint32_t m_duplicateCount;
+   
+   /**
+    * Last known position of each topology tuple
+    */
+   std::unordered_map<uint64_t, uint32_t> m_topology;
+   
+   /**
+    * T_dest_addr of the indexed topology tuples of each T_last_addr. The
+    * vectors keep their memory when they are emptied
+    */
+   std::unordered_map<uint32_t, std::vector<Ipv4Address> > m_lastAddresses;
+   
+   /**
+    * Expected size of the topology set
+    */
+   uint32_t m_topologyCount;
+
+};
+
+#endif
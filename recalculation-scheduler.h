@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef RECALCULATION_SCHEDULER_H
+#define RECALCULATION_SCHEDULER_H
+
+#include "noria.h"
+#include <stdint.h>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Schedules the routing table recalculations of the agents. Each agent has
+ * a single pending event: the periodic recalculations are staggered along
+ * the period (with a deterministic jitter per agent), and a recalculation
+ * requested by a reservation is done at once, or when the minimum interval
+ * since the last one of the agent has passed, joined with the next
+ * periodic one if that comes first
+ */
+class RecalculationScheduler {
+
+   public:
+   
+   /**
+    *
+    */
+   RecalculationScheduler (void);
+   
+   /**
+    * Adds an agent, in the order of its index
+    */
+   void Add (Ptr<Noria> noria);
+   
+   /**
+    *
+    */
+   void Clear (void);
+   
+   /**
+    * Recalculation requested by the agent when its routing table cannot be
+    * repaired after a change of the reserved nodes
+    */
+   void Request (uint32_t index);
+   
+   /**
+    * Indicates if the periodic recalculations are done in batch by the
+    * NoriaContainer. In that case the requests that must wait are left to
+    * the next batch
+    */
+   void SetBatch (bool batch);
+   
+   /**
+    * Minimum time (in seconds) between the recalculations of an agent
+    * requested by reservations
+    */
+   void SetMinInterval (double interval);
+   
+   /**
+    * Schedules the first periodic recalculation of each agent
+    */
+   void Start (double period);
+   
+   
+   private:
+   
+   /**
+    * Moves the next periodic recalculation of the agent after the current
+    * simulation time
+    */
+   void AdvanceSlot (uint32_t index);
+   
+   /**
+    * Deterministic jitter of the agent, in [0, 1)
+    */
+   static double GetJitter (uint32_t index);
+   
+   /**
+    * Time (in seconds) of the next periodic recalculation of the agent
+    */
+   double GetSlotTime (uint32_t index);
+   
+   /**
+    *
+    */
+   void Recalculate (uint32_t index);
+   
+   /**
+    * Replaces the pending event of the agent. The event is always after the
+    * current simulation time
+    */
+   void Schedule (uint32_t index, double time);
+   
+   /**
+    *
+    */
+   std::vector<Ptr<Noria> > v_norias;
+   
+   /**
+    * Pending recalculation of each agent
+    */
+   std::vector<EventId> v_events;
+   
+   /**
+    * Time (in seconds) of the pending recalculation of each agent
+    */
+   std::vector<double> v_times;
+   
+   /**
+    * Offset (in seconds) of the periodic recalculations of each agent
+    */
+   std::vector<double> v_offsets;
+   
+   /**
+    * Number k of the next periodic recalculation of each agent, which is at
+    * offset + k * period. It is counted instead of being computed from the
+    * current time, since the simulation time is rounded to nanoseconds
+    */
+   std::vector<uint64_t> v_slots;
+   
+   /**
+    *
+    */
+   double m_period;
+   
+   /**
+    *
+    */
+   double m_minInterval;
+   
+   /**
+    *
+    */
+   bool m_batch;
+
+};
+
+#endif
+
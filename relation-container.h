@@ -35,7 +35,11 @@ struct AddressRelation {
 
 
 /**
- * Class that manages the address relations
+ * Class that manages the address relations. When shared, the relations
+ * between the MAC and the IP address of a same node are not copied: they
+ * are read from the simulation-wide AddressTable and the container only
+ * keeps one visibility bit per node. Any other relation, or a shared one
+ * that gets updated, is stored in the private vector
  */
 class RelationContainer {
 
@@ -81,6 +85,11 @@ class RelationContainer {
     */
    bool Related (Mac48Address mac, Ipv4Address ip);
    
+   /**
+    *
+    */
+   void SetShared (bool shared);
+   
    /**
     *
     */
@@ -104,10 +113,50 @@ class RelationContainer {
    
    private:
    
+   /**
+    * Position of the first relation with the IP address, searched in the vector
+    */
+   uint32_t FindIp (Ipv4Address ip);
+   
+   /**
+    * Indicates if the relation of the node with the ID is visible
+    */
+   bool IsVisible (uint16_t id);
+   
+   /**
+    *
+    */
+   void SetVisible (uint16_t id, bool visible);
+   
    /**
     *
     */
    std::vector<AddressRelation> v_relations;
+   
+   /**
+    * Position of the relation of each MAC address
+    */
+   AddressIndex m_macIndex;
+   
+   /**
+    * Position of the first relation of each IP address
+    */
+   AddressIndex m_ipIndex;
+   
+   /**
+    * Indicates if the shared relations are used
+    */
+   bool m_shared;
+   
+   /**
+    * Number of visible shared relations
+    */
+   uint32_t m_sharedSize;
+   
+   /**
+    * Visibility bit of the shared relation of each node
+    */
+   std::vector<uint64_t> v_visible;
 
 };
 
@@ -7,6 +7,9 @@
 #ifndef RESERVED_CONTAINER_H
 #define RESERVED_CONTAINER_H
 
+#include <functional>
+#include <queue>
+
 using namespace ns3;
 
 /**
@@ -46,9 +49,10 @@ class ReservedContainer {
    ReservedContainer (void);
    
    /**
-    *
+    * Adds the IP address as reserved. If it is already reserved, its time
+    * is refreshed. Returns true if the IP address was not reserved
     */
-   void Add (Ipv4Address ip, double time);
+   bool Add (Ipv4Address ip, double time);
    
    /**
     *
@@ -60,6 +64,19 @@ class ReservedContainer {
     */
    bool Exist (Ipv4Address ip);
    
+   /**
+    * Writes the reserved IP addresses into addresses, sorted, so that two
+    * sets can be compared exactly when their fingerprints are equal
+    */
+   void GetAddresses (std::vector<uint32_t> &addresses);
+   
+   /**
+    * Fingerprint of the set of reserved IP addresses, updated when an IP
+    * address is added or erased (not when its time is refreshed). Equal
+    * sets have the same fingerprint, whatever the order of the changes
+    */
+   uint64_t GetFingerprint (void);
+   
    /**
     *
     */
@@ -81,9 +98,11 @@ class ReservedContainer {
    double GetTime (Ipv4Address ip);
    
    /**
-    *
+    * Removes the reserved nodes whose lifetime expired and appends their IP
+    * addresses to expired. Only the expired entries (at the top of the
+    * expiry heap) are visited
     */
-   void Update (double time);
+   void Update (double time, std::vector<Ipv4Address> &expired);
    
    /**
     *
@@ -91,18 +110,50 @@ class ReservedContainer {
    void Write (void);
    
    /**
-    *
+    * Writes the reserved nodes from the oldest to the newest
     */
    void Write (std::string fileName);
    
    
    private:
    
+   /**
+    * Entry of the expiry heap: time of the reservation and IP address
+    */
+   typedef std::pair<double, uint32_t> Expiry;
+   
+   /**
+    * Hash of an IP address in the fingerprint
+    */
+   static uint64_t GetHash (Ipv4Address ip);
+   
+   /**
+    * Order of the reserved nodes in the registry file: by time, and by IP
+    * address for equal times
+    */
+   static bool IsOlder (const Reserved &a, const Reserved &b);
+   
    /**
     *
     */
    std::vector<Reserved> v_reserved;
    
+   /**
+    * Position of each reserved IP address in the vector
+    */
+   AddressIndex m_index;
+   
+   /**
+    * XOR of the hashes of the reserved IP addresses
+    */
+   uint64_t m_fingerprint;
+   
+   /**
+    * Reserved IP addresses ordered by time (the oldest at the top). An entry
+    * may be outdated if the IP address was refreshed or erased
+    */
+   std::priority_queue<Expiry, std::vector<Expiry>, std::greater<Expiry> > m_expiry;
+   
 };
 
 #endif
@@ -0,0 +1,207 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef ROUTINGTABLE_CONTAINER_H
+#define ROUTINGTABLE_CONTAINER_H
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Struct where a route to an HNA network is stored
+ */
+struct HnaRoute {
+
+   /**
+    *
+    */
+   Ipv4Address h_network;
+   
+   /**
+    *
+    */
+   Ipv4Mask h_netmask;
+   
+   /**
+    * The next hop towards the gateway of the network
+    */
+   Ipv4Address h_nextAddr;
+   
+   /**
+    *
+    */
+   uint32_t h_interface;
+   
+   /**
+    * Distance (in hops) to the gateway of the network
+    */
+   uint32_t h_metric;
+   
+   /**
+    * HNA route creator
+    */
+   HnaRoute (Ipv4Address network, Ipv4Mask netmask, Ipv4Address nextAddr, uint32_t interface, uint32_t metric) {
+      h_network.Set(network.Get());
+      h_netmask = netmask;
+      h_nextAddr.Set(nextAddr.Get());
+      h_interface = interface;
+      h_metric = metric;
+   };
+};
+
+
+/**
+ * Routing table computed by a Noria. It is built apart from the OLSR
+ * routing table, and Apply only writes to OLSR the routes that changed.
+ * The routes are kept in an array, and the position of each destination
+ * in an AddressIndex (array indexed by the ID of the node, hash table for
+ * the other addresses)
+ */
+class RoutingTableContainer {
+
+   public:
+   
+   /**
+    *
+    */
+   RoutingTableContainer (void);
+   
+   /**
+    * Adds the route to the destination, replacing the previous one
+    */
+   void AddEntry (Ipv4Address dest, Ipv4Address next, uint32_t interface, uint32_t distance);
+   
+   /**
+    *
+    */
+   void AddHnaRoute (Ipv4Address network, Ipv4Mask netmask, Ipv4Address next, uint32_t interface, uint32_t metric);
+   
+   /**
+    * Makes the OLSR routing tables (hosts and HNA) equal to this one.
+    * Returns true if any route of OLSR was inserted, removed or changed
+    */
+   bool Apply (Ptr<olsr::RoutingProtocol> olsr);
+   
+   /**
+    * Removes the routes to the hosts and to the HNA networks
+    */
+   void Clear (void);
+   
+   /**
+    * Position of the HNA route to the network (GetNHnaRoutes if there is none)
+    */
+   uint32_t FindHnaRoute (Ipv4Address network, Ipv4Mask netmask);
+   
+   /**
+    *
+    */
+   const RoutingTableEntry &GetEntry (uint32_t index);
+   
+   /**
+    *
+    */
+   uint32_t GetHnaMetric (uint32_t index);
+   
+   /**
+    *
+    */
+   uint32_t GetNHnaRoutes (void);
+   
+   /**
+    *
+    */
+   uint32_t GetSize (void);
+   
+   /**
+    *
+    */
+   bool Lookup (Ipv4Address dest, RoutingTableEntry &entry);
+   
+   /**
+    *
+    */
+   void RemoveEntry (Ipv4Address dest);
+   
+   /**
+    *
+    */
+   void RemoveHnaRoute (uint32_t index);
+   
+   
+   private:
+   
+   /**
+    *
+    */
+   bool ApplyHnaRoutes (Ptr<Ipv4StaticRouting> hnaRoutingTable);
+   
+   /**
+    *
+    */
+   static bool Equal (const RoutingTableEntry &a, const RoutingTableEntry &b);
+   
+   /**
+    * Routes to the hosts, in no particular order
+    */
+   std::vector<RoutingTableEntry> v_entries;
+   
+   /**
+    * Position of the route of each destination
+    */
+   AddressIndex m_index;
+   
+   /**
+    * Routes already found in the OLSR table during Apply
+    */
+   std::vector<bool> v_applied;
+   
+   /**
+    *
+    */
+   std::vector<HnaRoute> v_hnaRoutes;
+
+};
+
+
+/**
+ * Routing table computed by a Noria, kept with the snapshot of the OLSR
+ * state and the reserved nodes it was computed from
+ */
+struct ComputedRoutes {
+
+   /**
+    * Snapshot of the OLSR state
+    */
+   StateSnapshot c_stateSnapshot;
+   
+   /**
+    * Fingerprint of the reserved nodes
+    */
+   uint64_t c_reservedFingerprint;
+   
+   /**
+    * Reserved IP addresses, sorted
+    */
+   std::vector<uint32_t> c_reservedAddresses;
+   
+   /**
+    *
+    */
+   RoutingTableContainer c_routes;
+   
+   /**
+    * Computed routes creator
+    */
+   ComputedRoutes (const StateSnapshot &stateSnapshot, uint64_t reservedFingerprint, const std::vector<uint32_t> &reservedAddresses, const RoutingTableContainer &routes) : c_routes (routes) {
+      c_stateSnapshot = stateSnapshot;
+      c_reservedFingerprint = reservedFingerprint;
+      c_reservedAddresses = reservedAddresses;
+   };
+};
+
+#endif
+
@@ -8,10 +8,23 @@
 #include "commons.h"
 #include "noria-container.h"
 #include "noria-simulation.h"
+#include "recalculation-scheduler.h"
 #include <ns3/flow-monitor-helper.h>
 #include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 #define OLSR_WILL_NEVER 0
+#define OLSR_WILL_DEFAULT 3
+#define OLSR_WILL_ALWAYS 7
+#define OLSR_DUP_HOLD_TIME Seconds (30)
+#define OLSR_ASYM_LINK 1
+#define OLSR_SYM_LINK 2
+#define OLSR_LOST_LINK 3
+#define OLSR_NOT_NEIGH 0
+#define OLSR_SYM_NEIGH 1
+#define OLSR_MPR_NEIGH 2
 
 using namespace ns3;
 
@@ -19,581 +32,3740 @@ std::string filePrefix = "";
 
 const std::string Commons::asciiRegistry     = "asciiRegistry";
 const std::string Commons::dataRegistry      = "dataRegistry.csv";
+const std::string Commons::filterRegistry    = "filterRegistry.csv";
 const std::string Commons::flowRegistry      = "flowRegistry.xml";
 const std::string Commons::mobilityRegistry  = "mobilityRegistry.mob";
 const std::string Commons::noriaRegistry     = "noriaRegistry.csv";
+const std::string Commons::olsrRegistry      = "olsrRegistry.csv";
 const std::string Commons::pcapRegistry      = "pcapRegistry";
 const std::string Commons::receivedRegistry  = "receivedRegistry.csv";
+const std::string Commons::recalculationRegistry = "recalculationRegistry.csv";
 const std::string Commons::relationsRegistry = "relationsRegistry.txt";
 const std::string Commons::reservedRegistry  = "reservedRegistry.txt";
 const std::string Commons::sentRegistry      = "sentRegistry.csv";
 const std::string Commons::stateRegistry     = "stateRegistry.csv";
+const std::string Commons::tapRegistry       = "tapRegistry.csv";
 
 const std::string Commons::csvSymbol         = ";";
 const double Commons::RESERVED_LIFETIME      = 2;
+const double Commons::FRAME_TAP_LIFETIME     = 0.1;
+const double Commons::TRANSMISSION_LIFETIME  = 10;
+const uint32_t Commons::TRANSMISSION_CAPACITY = 256;
 const uint16_t Commons::OLSR_PORT            = 698;
+const uint32_t Commons::ROUTES_CACHE_CAPACITY = 4;
+
+const uint16_t AddressTable::INVALID_ID;
+const uint32_t AddressIndex::NOT_FOUND;
+const std::vector<uint32_t> AddressBuckets::EMPTY;
+const uint32_t OlsrStateIndex::SYM_NEIGHBOR;
+const uint32_t OlsrStateIndex::WILLING_NEIGHBOR;
+const uint32_t FrameDecoder::HEADER_BYTES;
+const uint64_t NoriaContainer::BATCH_WAIT_NS;
+const uint32_t OlsrReceiver::MESSAGE_HEADER_BYTES;
+const uint32_t OlsrReceiver::PACKET_HEADER_BYTES;
 
 NS_LOG_COMPONENT_DEFINE("noria-simulation");
 
+// Identificadores de las direcciones de los nodos
+AddressTable addresses;
+
 // Contenedor de los Noria
 NoriaContainer norias;
 
+// Planificador de los recalculos de las tablas de enrutamiento de los Noria
+RecalculationScheduler scheduler;
+
+// Filtro de las tramas escuchadas por los Noria
+FrameFilter filter;
+
+// Decodificador de las transmisiones escuchadas por los Noria
+FrameTap tap;
+
 /**
- *
+ * Static procedure called by callback when the routing tables of all the Norias are recalculated in batch
  */
-static void RecalculateTable (uint32_t index) {
-   double period = norias.GetRecalculateRoutingTablePeriod (index);     // Se obtiene el periodo (en segundos) en el que se debe recalcular la tabla de enrutamiento
-   norias.RecalculateRoutingTable (index);                              // Se recalcula la tabla de enrutamiento
-   Simulator::Schedule (Seconds (period), &RecalculateTable, index);    // Se indica que se debe volver a recalcular dentro del tiempo indicado
+static void RecalculateTables (double period) {
+   norias.RecalculateRoutingTables ();
+   Simulator::Schedule (Seconds (period), &RecalculateTables, period);
 }
 
 /**
- * Static procedure called by callback when a net device receive a packet
+ * Static procedure called by callback when a net device receive a packet.
+ * The Noria is bound to the callback at Noria::Install, so the agent is
+ * found without looking up the MAC address of the device. The frame was
+ * decoded when it was transmitted (see SendPacket).
  */
-static void ReceivePacket (Ptr<WifiNetDevice> device, Ptr<const Packet> packet, uint16_t channelFreqMhz, uint16_t channelNumber, uint32_t rate, bool isShortPreamble, double signalDbm, double noiseDbm) {
-   Mac48Address address = Mac48Address::ConvertFrom (device->GetAddress ());
-   uint32_t index = norias.GetNoriaIndex (address);
-   if (index < norias.GetSize ()) {
-      norias.ReceivePacketProcess (index, packet->Copy ());
+static void ReceivePacket (Ptr<Noria> noria, Ptr<const Packet> packet, uint16_t channelFreqMhz, uint16_t channelNumber, uint32_t rate, bool isShortPreamble, double signalDbm, double noiseDbm) {
+   FrameInfo frame;
+   if (filter.AcceptReceived (tap.Receive (packet, frame))) {
+      noria->ReceivePacketProcess (frame);
    }
 }
 
+/**
+ * Static procedure called by callback when the Norias need to forget their old transmissions.
+ * A single event sweeps all the agents
+ */
+static void AgeTransmissions (double period) {
+   double now = Simulator::Now ().GetSeconds ();
+   norias.ExpireTransmissions (now);
+   Simulator::Schedule (Seconds (period), &AgeTransmissions, period);
+}
+
 /**
  * Static procedure called by callback when a Noria have to reset its reservation info
  */
-static void ResetNoria (uint32_t index) {
-   norias.Reset (index);
+static void ResetNoria (Ptr<Noria> noria) {
+   noria->ExpireReservation ();
+}
+
+/**
+ * Static procedure called by callback when the OLSR routing table of a Noria changes
+ */
+static void RoutingTableChanged (Ptr<Noria> noria, uint32_t size) {
+   noria->NotifyRoutingTableChanged ();
 }
 
 /**
- * Static procedure called by callback when a net device sent a packet
+ * Static procedure called by callback when a net device sent a packet.
+ * The Noria is bound to the callback at Noria::Install.
  */
-static void SendPacket (Ptr<WifiNetDevice> device, Ptr<const Packet> packet, uint16_t channelFreqMhz, uint16_t channelNumber, uint32_t rate, bool isShortPreamble) {
-   Mac48Address address = Mac48Address::ConvertFrom (device->GetAddress ());
-   uint32_t index = norias.GetNoriaIndex (address);
-   if (index < norias.GetSize ()) {
-      norias.SendPacketProcess (index, packet->Copy ());
+static void SendPacket (Ptr<Noria> noria, Ptr<const Packet> packet, uint16_t channelFreqMhz, uint16_t channelNumber, uint32_t rate, bool isShortPreamble) {
+   FrameInfo frame;
+   if (filter.AcceptSent (tap.Transmit (packet, frame))) {
+      noria->SendPacketProcess (frame);
    }
 }
 
 /**
- * Static procedure called by callback when a Noria needs to update its reserved registry
+ * Static procedure called by callback when the Norias need to update their reserved registry.
+ * A single event sweeps all the agents
  */
-static void UpdateReserved (uint32_t index) {
+static void UpdateReserved (void) {
    double now = Simulator::Now ().GetSeconds ();
-   norias.UpdateReservedNodes (index, now);
-   Simulator::Schedule (Seconds (Commons::RESERVED_LIFETIME), &UpdateReserved, index);
+   norias.UpdateReservedNodes (now);
+   Simulator::Schedule (Seconds (Commons::RESERVED_LIFETIME), &UpdateReserved);
 }
 
 /**
  * Static procedure called by callback when a Noria have to write in file its reservation state
  */
 /*
-static void WriteStates (uint32_t index) {
-   norias.WriteReservationState (index);
+static void WriteStates (Ptr<Noria> noria) {
+   noria->WriteReservationState ();
 }
 */
 
 
 /**
  * +-------------------------------------------------------------------------+
- * | Clase RelationContainer                                                 |
+ * | Clase AddressTable                                                      |
  * +-------------------------------------------------------------------------+
  */
 
 /**
  *
  */
-RelationContainer::RelationContainer (void) {
+AddressTable::AddressTable (void) : m_macBase (0), m_ipBase (0), m_build (false) {
 }
 
 /**
  *
  */
-void RelationContainer::Add (Mac48Address mac, Ipv4Address ip) {
-   if (!Exist (mac)) {
-      AddressRelation a (mac, ip);
-      v_relations.push_back (a);
+uint16_t AddressTable::Add (Mac48Address mac, Ipv4Address ip) {
+   if (v_ips.size() >= INVALID_ID) {
+      return INVALID_ID;                        //No hay mas identificadores de 16 bits
    }
+   uint16_t id = v_ips.size();
+   v_macs.push_back (mac);
+   v_ips.push_back (ip);
+   m_macIds[GetKey (mac)] = id;
+   m_ipIds[ip.Get()] = id;
+   m_build = true;
+   return id;
 }
 
 /**
- *
+ * The arrays are built when the span of the addresses is at most four
+ * times the number of nodes; otherwise the hash tables are used.
  */
-bool RelationContainer::Exist (Mac48Address mac) {
-   uint32_t n = v_relations.size();
-   uint32_t i = 0;
-   bool found = false;
-   while (!found && i < n) {
-      if (v_relations[i].r_mac == mac) {
-         found = true;
+void AddressTable::Build (void) {
+   if (!m_build) {
+      return;
+   }
+   m_build = false;
+   v_macIds.clear ();
+   v_ipIds.clear ();
+   uint32_t n = v_ips.size();
+   if (n == 0) {
+      return;
+   }
+   uint64_t minMac = GetKey (v_macs[0]);
+   uint64_t maxMac = minMac;
+   uint32_t minIp = v_ips[0].Get();
+   uint32_t maxIp = minIp;
+   for (uint32_t i = 1;i < n;i += 1) {
+      uint64_t mac = GetKey (v_macs[i]);
+      uint32_t ip = v_ips[i].Get();
+      minMac = std::min (minMac, mac);
+      maxMac = std::max (maxMac, mac);
+      minIp = std::min (minIp, ip);
+      maxIp = std::max (maxIp, ip);
+   }
+   uint64_t span = 4 * (uint64_t) n + 16;
+   if (maxMac - minMac < span) {
+      m_macBase = minMac;
+      v_macIds.assign (maxMac - minMac + 1, INVALID_ID);
+      for (uint32_t i = 0;i < n;i += 1) {
+         v_macIds[GetKey (v_macs[i]) - minMac] = i;
       }
-      else {
-         i += 1;
+   }
+   if (maxIp - minIp < span) {
+      m_ipBase = minIp;
+      v_ipIds.assign (maxIp - minIp + 1, INVALID_ID);
+      for (uint32_t i = 0;i < n;i += 1) {
+         v_ipIds[v_ips[i].Get() - minIp] = i;
       }
    }
-   return found;
 }
 
 /**
  *
  */
-bool RelationContainer::Exist (Ipv4Address ip) {
-   uint32_t n = v_relations.size();
-   uint32_t i = 0;
-   bool found = false;
-   while (!found && i < n) {
-      if (v_relations[i].r_ip == ip) {
-         found = true;
-      }
-      else {
-         i += 1;
-      }
-   }
-   return found;
+void AddressTable::Clear (void) {
+   v_macs.clear ();
+   v_ips.clear ();
+   m_macIds.clear ();
+   m_ipIds.clear ();
+   v_macIds.clear ();
+   v_ipIds.clear ();
+   m_build = false;
 }
 
 /**
  *
  */
-Ipv4Address RelationContainer::GetIp (Mac48Address mac) {
-   uint32_t n = v_relations.size();
-   uint32_t i = 0;
-   bool found = false;
-   Ipv4Address ip;
-   while (!found && i < n) {
-      if (v_relations[i].r_mac == mac) {
-         found = true;
-         ip.Set(v_relations[i].r_ip.Get());
-      }
-      else {
-         i += 1;
-      }
+uint16_t AddressTable::GetId (Mac48Address mac) {
+   if (m_build) {
+      Build ();
    }
-   return ip;
+   uint64_t key = GetKey (mac);
+   if (!v_macIds.empty()) {
+      uint64_t offset = key - m_macBase;                //Las direcciones menores que la base dan un desplazamiento enorme
+      return (offset < v_macIds.size()) ? v_macIds[offset] : INVALID_ID;
+   }
+   std::unordered_map<uint64_t, uint16_t>::const_iterator it = m_macIds.find (key);
+   return (it != m_macIds.end()) ? it->second : INVALID_ID;
 }
 
 /**
  *
  */
-Mac48Address RelationContainer::GetMac (Ipv4Address ip) {
-   uint32_t n = v_relations.size();
-   uint32_t i = 0;
-   bool found = false;
-   Mac48Address mac;
-   while (!found && i < n) {
-      if (v_relations[i].r_ip == ip) {
-         found = true;
-         mac = Mac48Address::ConvertFrom (v_relations[i].r_mac);
-      }
-      else {
-         i += 1;
-      }
+uint16_t AddressTable::GetId (Ipv4Address ip) {
+   if (m_build) {
+      Build ();
    }
-   return mac;
+   if (!v_ipIds.empty()) {
+      uint32_t offset = ip.Get() - m_ipBase;            //Las direcciones menores que la base dan un desplazamiento enorme
+      return (offset < v_ipIds.size()) ? v_ipIds[offset] : INVALID_ID;
+   }
+   std::unordered_map<uint32_t, uint16_t>::const_iterator it = m_ipIds.find (ip.Get());
+   return (it != m_ipIds.end()) ? it->second : INVALID_ID;
 }
 
 /**
  *
  */
-uint32_t RelationContainer::GetSize (void) {
-   return v_relations.size();
+Ipv4Address AddressTable::GetIp (uint16_t id) {
+   Ipv4Address ip;
+   if (id < v_ips.size()) {
+      ip.Set(v_ips[id].Get());
+   }
+   return ip;
 }
 
 /**
  *
  */
-bool RelationContainer::Related (Mac48Address mac, Ipv4Address ip) {
-   bool related = false;
-   if (ip == GetIp(mac)) {
-      related = true;
+uint64_t AddressTable::GetKey (Mac48Address mac) {
+   uint8_t buffer[6];
+   mac.CopyTo (buffer);
+   uint64_t key = 0;
+   for (uint32_t i = 0;i < 6;i += 1) {
+      key = (key << 8) | buffer[i];
    }
-   return related;
+   return key;
 }
 
 /**
  *
  */
-void RelationContainer::Show (void) {
-   uint32_t n = v_relations.size();
-   for (uint32_t i = 0; i < n; i++) {
-      std::cout << "-> Mac: " << v_relations[i].r_mac 
-                << " IP: " << v_relations[i].r_ip 
-                << std::endl;
+Mac48Address AddressTable::GetMac (uint16_t id) {
+   Mac48Address mac;
+   if (id < v_macs.size()) {
+      mac = v_macs[id];
    }
+   return mac;
 }
 
 /**
  *
  */
-void RelationContainer::UpdateRelation (Mac48Address mac, Ipv4Address ip) {
-   uint32_t n = v_relations.size();
-   uint32_t i = 0;
-   bool found = false;
-   while (!found && i < n) {
-      if (v_relations[i].r_mac == mac) {
-         found = true;
-         v_relations[i].r_ip.Set (ip.Get());
-      }
-      else {
-         i += 1;
-      }
-   }
+uint32_t AddressTable::GetSize (void) {
+   return v_ips.size();
 }
 
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase AddressIndex                                                      |
+ * +-------------------------------------------------------------------------+
+ */
+
 /**
  *
  */
-void RelationContainer::Write (void) {
-   uint32_t n = v_relations.size();
-   std::ofstream write((filePrefix + Commons::relationsRegistry).c_str(), std::ios::app);
-   for (uint32_t i = 0; i < n; i++) {
-      write << "-> MAC: " << v_relations[i].r_mac << " IP: " << v_relations[i].r_ip << std::endl;
-   }
-   write << std::endl;
-   write.close();
+AddressIndex::AddressIndex (void) {
 }
 
 /**
  *
  */
-void RelationContainer::Write (std::string fileName) {
-   uint32_t n = v_relations.size();
-   std::ofstream write(fileName.c_str(), std::ios::app);
-   for (uint32_t i = 0; i < n; i++) {
-      write << "-> MAC: " << v_relations[i].r_mac << " IP: " << v_relations[i].r_ip << std::endl;
-   }
-   write << std::endl;
-   write.close();
+void AddressIndex::Clear (void) {
+   v_positions.clear ();
+   m_others.clear ();
 }
 
 /**
- * +-------------------------------------------------------------------------+
- * | Clase ReservedContainer                                                 |
- * +-------------------------------------------------------------------------+
+ *
  */
+void AddressIndex::Erase (Mac48Address mac) {
+   Erase (addresses.GetId (mac), AddressTable::GetKey (mac));
+}
 
 /**
  *
  */
-ReservedContainer::ReservedContainer (void) {
+void AddressIndex::Erase (Ipv4Address ip) {
+   Erase (addresses.GetId (ip), ip.Get());
 }
 
 /**
  *
  */
-void ReservedContainer::Add (Ipv4Address ip, double time) {
-   if (!Exist (ip)) {
-      Reserved r (ip, time);
-      v_reserved.push_back (r);
+void AddressIndex::Erase (uint16_t id, uint64_t key) {
+   if (id == AddressTable::INVALID_ID) {
+      m_others.erase (key);
+   }
+   else if (id < v_positions.size()) {
+      v_positions[id] = NOT_FOUND;
    }
 }
 
 /**
  *
  */
-void ReservedContainer::Erase (uint32_t index) {
-   v_reserved.erase (v_reserved.begin() + index);
+uint32_t AddressIndex::Find (Mac48Address mac) {
+   return Find (addresses.GetId (mac), AddressTable::GetKey (mac));
 }
 
 /**
  *
  */
-bool ReservedContainer::Exist (Ipv4Address ip) {
-   uint32_t n = v_reserved.size();
-   uint32_t i = 0;
-   bool found = false;
-   while (!found && i < n) {
-      if (v_reserved[i].r_ip == ip) {
-         found = true;
-      }
-      else {
-         i += 1;
-      }
-   }
-   return found;
+uint32_t AddressIndex::Find (Ipv4Address ip) {
+   return Find (addresses.GetId (ip), ip.Get());
 }
 
 /**
  *
  */
-Ipv4Address ReservedContainer::GetIp (uint32_t index) {
-   Ipv4Address ip;
-   ip.Set(v_reserved[index].r_ip.Get());
-   return ip;
+uint32_t AddressIndex::Find (uint16_t id, uint64_t key) {
+   if (id == AddressTable::INVALID_ID) {
+      std::unordered_map<uint64_t, uint32_t>::const_iterator it = m_others.find (key);
+      return (it != m_others.end()) ? it->second : NOT_FOUND;
+   }
+   return (id < v_positions.size()) ? v_positions[id] : NOT_FOUND;
 }
 
 /**
  *
  */
-uint32_t ReservedContainer::GetSize (void) {
-   return v_reserved.size();
+void AddressIndex::Set (Mac48Address mac, uint32_t position) {
+   Set (addresses.GetId (mac), AddressTable::GetKey (mac), position);
 }
 
 /**
  *
  */
-double ReservedContainer::GetTime (uint32_t index) {
-   return v_reserved[index].r_time;
+void AddressIndex::Set (Ipv4Address ip, uint32_t position) {
+   Set (addresses.GetId (ip), ip.Get(), position);
 }
 
 /**
- *
+ * The array grows up to the number of nodes the first time it is used
  */
-double ReservedContainer::GetTime (Ipv4Address ip) {
-   uint32_t n = v_reserved.size();
-   uint32_t i = 0;
-   bool found = false;
-   double time = 0;
-   while (!found && i < n) {
-      if (v_reserved[i].r_ip == ip) {
-         found = true;
-         time = v_reserved[i].r_time;
-      }
-      else {
-         i += 1;
+void AddressIndex::Set (uint16_t id, uint64_t key, uint32_t position) {
+   if (id == AddressTable::INVALID_ID) {
+      m_others[key] = position;
+   }
+   else {
+      if (id >= v_positions.size()) {
+         v_positions.resize (std::max ((uint32_t) id + 1, addresses.GetSize()), NOT_FOUND);
       }
+      v_positions[id] = position;
    }
-   return time;
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase AddressBuckets                                                    |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+AddressBuckets::AddressBuckets (void) : m_size (0) {
 }
 
 /**
  *
  */
-void ReservedContainer::Update (double time) {
-   uint32_t n = v_reserved.size();
-   std::vector<Reserved> temp;
-   for (uint32_t i = 0;i < n;i += 1) {
-      if (time - v_reserved[i].r_time < Commons::RESERVED_LIFETIME) {
-         Reserved r (v_reserved[i].r_ip, v_reserved[i].r_time);
-         temp.push_back (r);
+void AddressBuckets::Add (Ipv4Address address, uint32_t position) {
+   uint32_t bucket = m_index.Find (address);
+   if (bucket == AddressIndex::NOT_FOUND) {
+      bucket = m_size;
+      m_size += 1;
+      m_index.Set (address, bucket);
+      if (bucket == v_buckets.size ()) {
+         v_buckets.push_back (std::vector<uint32_t> ());
       }
    }
-   v_reserved = temp;
+   v_buckets[bucket].push_back (position);
 }
 
 /**
  *
  */
-void ReservedContainer::Write (void) {
-   uint32_t n = v_reserved.size();
-   std::ofstream write((filePrefix + Commons::reservedRegistry).c_str(), std::ios::app);
-   for (uint32_t i = 0; i < n; i++) {
-      write << "-> IP: " << v_reserved[i].r_ip << " TIME: " << v_reserved[i].r_time << std::endl;
+void AddressBuckets::Clear (void) {
+   m_index.Clear ();
+   for (uint32_t i = 0; i < m_size; i++) {
+      v_buckets[i].clear ();
    }
-   write << std::endl;
-   write.close();
+   m_size = 0;
 }
 
 /**
  *
  */
-void ReservedContainer::Write (std::string fileName) {
-   uint32_t n = v_reserved.size();
-   std::ofstream write(fileName.c_str(), std::ios::app);
-   for (uint32_t i = 0; i < n; i++) {
-      write << "-> IP: " << v_reserved[i].r_ip << " TIME: " << v_reserved[i].r_time << std::endl;
-   }
-   write << std::endl;
-   write.close();
+const std::vector<uint32_t> &AddressBuckets::Get (Ipv4Address address) {
+   uint32_t bucket = m_index.Find (address);
+   return (bucket != AddressIndex::NOT_FOUND) ? v_buckets[bucket] : EMPTY;
 }
 
 /**
  * +-------------------------------------------------------------------------+
- * | Clase TransmissionInfoContainer                                         |
+ * | Clase OlsrStateIndex                                                    |
  * +-------------------------------------------------------------------------+
  */
 
-
 /**
  *
  */
-TransmissionInfoContainer::TransmissionInfoContainer () {
+OlsrStateIndex::OlsrStateIndex (void) : m_built (false) {
 }
 
 /**
- *
+ * Only the first tuple of an address is indexed, as OlsrState finds it
  */
-void TransmissionInfoContainer::Add (Ipv4Address ip, double time) {
-   if (!Exist (ip)) {
-      TransmissionInfo t (ip, time);
-      v_transmissions.push_back (t);
+void OlsrStateIndex::Build (const OlsrState &state, const StateSnapshot &snapshot) {
+   if (m_built && snapshot == m_snapshot) {
+      return;
    }
-   else {
-      Update (ip, time);
+   m_built = true;
+   m_snapshot = snapshot;
+   
+   m_neighbors.Clear ();
+   const NeighborSet &neighbors = state.GetNeighbors ();
+   for (NeighborSet::const_iterator it = neighbors.begin (); it != neighbors.end (); it++) {
+      uint32_t flags = m_neighbors.Find (it->neighborMainAddr);
+      if (flags == AddressIndex::NOT_FOUND) {
+         flags = 0;
+      }
+      if (it->status == NeighborTuple::STATUS_SYM) {
+         flags |= SYM_NEIGHBOR;
+      }
+      if (it->willingness != OLSR_WILL_NEVER) {
+         flags |= WILLING_NEIGHBOR;
+      }
+      m_neighbors.Set (it->neighborMainAddr, flags);
+   }
+   
+   m_mainAddresses.clear ();
+   const IfaceAssocSet &ifaceAssocSet = state.GetIfaceAssocSet ();
+   for (IfaceAssocSet::const_iterator it = ifaceAssocSet.begin (); it != ifaceAssocSet.end (); it++) {
+      m_mainAddresses.insert (std::make_pair (it->ifaceAddr.Get (), it->mainAddr));
+   }
+   
+   m_lastAddrTuples.Clear ();
+   m_destAddrTuples.Clear ();
+   const TopologySet &topology = state.GetTopologySet ();
+   for (uint32_t i = 0; i < topology.size (); i++) {
+      m_lastAddrTuples.Add (topology[i].lastAddr, i);
+      m_destAddrTuples.Add (topology[i].destAddr, i);
    }
 }
 
 /**
  *
  */
-void TransmissionInfoContainer::Erase (Ipv4Address ip) {
-   uint32_t n = v_transmissions.size();
-   std::vector<TransmissionInfo> temp;
-   for (uint32_t i = 0;i < n;i += 1) {
-      if (v_transmissions[i].t_dstIp != ip) {
-         TransmissionInfo t (v_transmissions[i].t_dstIp, v_transmissions[i].t_time);
-         temp.push_back(t);
-      }
-   }
-   v_transmissions = temp;
+const std::vector<uint32_t> &OlsrStateIndex::GetDestAddrTuples (Ipv4Address destAddr) {
+   return m_destAddrTuples.Get (destAddr);
 }
 
 /**
  *
  */
-bool TransmissionInfoContainer::Exist (Ipv4Address ip) {
-   uint32_t n = v_transmissions.size();
-   uint32_t i = 0;
-   bool found = false;
-   while (!found && i < n) {
-      if (v_transmissions[i].t_dstIp == ip) {
-         found = true;
-      }
-      else {
-         i += 1;
-      }
-   }
-   return found;
+const std::vector<uint32_t> &OlsrStateIndex::GetLastAddrTuples (Ipv4Address lastAddr) {
+   return m_lastAddrTuples.Get (lastAddr);
 }
 
 /**
  *
  */
-double TransmissionInfoContainer::GetTime (Ipv4Address ip) {
-   uint32_t n = v_transmissions.size();
-   uint32_t i = 0;
-   bool found = false;
-   double time = 0;
-   while (!found && i < n) {
-      if (v_transmissions[i].t_dstIp == ip) {
-         found = true;
-         time = v_transmissions[i].t_time;
-      }
-      else {
-         i += 1;
-      }
-   }
-   return time;
+Ipv4Address OlsrStateIndex::GetMainAddress (Ipv4Address ifaceAddr) {
+   std::unordered_map<uint32_t, Ipv4Address>::const_iterator it = m_mainAddresses.find (ifaceAddr.Get ());
+   return (it != m_mainAddresses.end ()) ? it->second : ifaceAddr;
 }
 
 /**
  *
  */
-void TransmissionInfoContainer::Update (Ipv4Address ip, double time) {
-   uint32_t n = v_transmissions.size();
-   uint32_t i = 0;
-   bool found = false;
-   while (!found && i < n) {
-      if (v_transmissions[i].t_dstIp == ip) {
-         found = true;
-         if (v_transmissions[i].t_time < time) {
-            v_transmissions[i].t_time = time;
-         }
-      }
-      else {
-         i += 1;
-      }
-   }
+bool OlsrStateIndex::IsSymNeighbor (Ipv4Address mainAddr) {
+   uint32_t flags = m_neighbors.Find (mainAddr);
+   return flags != AddressIndex::NOT_FOUND && (flags & SYM_NEIGHBOR);
 }
 
 /**
  *
  */
-void TransmissionInfoContainer::Write (void) {
+bool OlsrStateIndex::IsWillingNeighbor (Ipv4Address mainAddr) {
+   uint32_t flags = m_neighbors.Find (mainAddr);
+   return flags != AddressIndex::NOT_FOUND && (flags & WILLING_NEIGHBOR);
 }
 
 /**
  * +-------------------------------------------------------------------------+
- * | Clase Noria                                                             |
+ * | Clase RelationContainer                                                 |
  * +-------------------------------------------------------------------------+
  */
 
 /**
  *
  */
-Noria::Noria () : n_reserved (false), n_reservedTime (0) {
+RelationContainer::RelationContainer (void) : m_shared (false), m_sharedSize (0) {
 }
 
 /**
  *
  */
-void Noria::AddRelation (Mac48Address mac, Ipv4Address ip) {
-   n_relations.Add (mac, ip);
+void RelationContainer::Add (Mac48Address mac, Ipv4Address ip) {
+   if (!Exist (mac)) {
+      if (m_shared) {
+         uint16_t id = addresses.GetId (mac);
+         if (id != AddressTable::INVALID_ID && addresses.GetIp (id) == ip) {
+            SetVisible (id, true);                      //La relacion es la del nodo, se comparte
+            return;
+         }
+      }
+      AddressRelation a (mac, ip);
+      v_relations.push_back (a);
+      m_macIndex.Set (mac, v_relations.size() - 1);
+      if (!Exist (ip)) {                                //Solo si la IP no tenia relacion
+         m_ipIndex.Set (ip, v_relations.size() - 1);
+      }
+   }
 }
 
 /**
  *
  */
-void Noria::AddReserved (Ipv4Address ip, double time) {
-   n_reservednodes.Add (ip, time);
+bool RelationContainer::Exist (Mac48Address mac) {
+   if (m_macIndex.Find (mac) != AddressIndex::NOT_FOUND) {
+      return true;
+   }
+   return m_shared && IsVisible (addresses.GetId (mac));
 }
 
 /**
  *
  */
-void Noria::AddTransmission (Ipv4Address ip, double time) {
-   n_transmissions.Add (ip, time);
+bool RelationContainer::Exist (Ipv4Address ip) {
+   if (m_ipIndex.Find (ip) != AddressIndex::NOT_FOUND) {
+      return true;
+   }
+   return m_shared && IsVisible (addresses.GetId (ip));
 }
 
 /**
  *
  */
-void Noria::EraseReservedNode (uint32_t reservedIndex) {
+uint32_t RelationContainer::FindIp (Ipv4Address ip) {
+   uint32_t n = v_relations.size();
+   uint32_t i = 0;
+   bool found = false;
+   while (!found && i < n) {
+      if (v_relations[i].r_ip == ip) {
+         found = true;
+      }
+      else {
+         i += 1;
+      }
+   }
+   return i;
+}
+
+/**
+ *
+ */
+Ipv4Address RelationContainer::GetIp (Mac48Address mac) {
+   Ipv4Address ip;
+   uint32_t i = m_macIndex.Find (mac);
+   if (i != AddressIndex::NOT_FOUND) {
+      ip.Set(v_relations[i].r_ip.Get());
+   }
+   else if (m_shared) {
+      uint16_t id = addresses.GetId (mac);
+      if (IsVisible (id)) {
+         ip.Set(addresses.GetIp (id).Get());
+      }
+   }
+   return ip;
+}
+
+/**
+ *
+ */
+Mac48Address RelationContainer::GetMac (Ipv4Address ip) {
+   Mac48Address mac;
+   uint32_t i = m_ipIndex.Find (ip);
+   if (i != AddressIndex::NOT_FOUND) {
+      mac = Mac48Address::ConvertFrom (v_relations[i].r_mac);
+   }
+   else if (m_shared) {
+      uint16_t id = addresses.GetId (ip);
+      if (IsVisible (id)) {
+         mac = addresses.GetMac (id);
+      }
+   }
+   return mac;
+}
+
+/**
+ *
+ */
+uint32_t RelationContainer::GetSize (void) {
+   return v_relations.size() + m_sharedSize;
+}
+
+/**
+ *
+ */
+bool RelationContainer::IsVisible (uint16_t id) {
+   uint32_t word = id / 64;
+   if (id == AddressTable::INVALID_ID || word >= v_visible.size()) {
+      return false;
+   }
+   return (v_visible[word] >> (id % 64)) & 1;
+}
+
+/**
+ *
+ */
+bool RelationContainer::Related (Mac48Address mac, Ipv4Address ip) {
+   bool related = false;
+   if (ip == GetIp(mac)) {
+      related = true;
+   }
+   return related;
+}
+
+/**
+ *
+ */
+void RelationContainer::SetShared (bool shared) {
+   m_shared = shared;
+}
+
+/**
+ *
+ */
+void RelationContainer::SetVisible (uint16_t id, bool visible) {
+   uint32_t word = id / 64;
+   uint64_t bit = (uint64_t) 1 << (id % 64);
+   if (word >= v_visible.size()) {
+      v_visible.resize (std::max (word + 1, (addresses.GetSize() + 63) / 64), 0);
+   }
+   if (visible && !(v_visible[word] & bit)) {
+      v_visible[word] |= bit;
+      m_sharedSize += 1;
+   }
+   else if (!visible && (v_visible[word] & bit)) {
+      v_visible[word] &= ~bit;
+      m_sharedSize -= 1;
+   }
+}
+
+/**
+ *
+ */
+void RelationContainer::Show (void) {
+   uint32_t n = v_relations.size();
+   for (uint32_t i = 0; i < n; i++) {
+      std::cout << "-> Mac: " << v_relations[i].r_mac 
+                << " IP: " << v_relations[i].r_ip 
+                << std::endl;
+   }
+   n = addresses.GetSize();
+   for (uint32_t i = 0; m_sharedSize > 0 && i < n; i++) {
+      if (IsVisible (i)) {
+         std::cout << "-> Mac: " << addresses.GetMac (i) 
+                   << " IP: " << addresses.GetIp (i) 
+                   << std::endl;
+      }
+   }
+}
+
+/**
+ *
+ */
+void RelationContainer::UpdateRelation (Mac48Address mac, Ipv4Address ip) {
+   uint32_t i = m_macIndex.Find (mac);
+   if (i == AddressIndex::NOT_FOUND && m_shared) {
+      uint16_t id = addresses.GetId (mac);
+      if (IsVisible (id) && !(addresses.GetIp (id) == ip)) {
+         SetVisible (id, false);                        //La relacion compartida cambia, se copia en el vector propio
+         Add (mac, ip);
+      }
+      return;
+   }
+   if (i != AddressIndex::NOT_FOUND) {
+      Ipv4Address old = v_relations[i].r_ip;
+      v_relations[i].r_ip.Set (ip.Get());
+      
+      // La IP anterior queda indexada en la primera relacion que aun la tenga
+      if (m_ipIndex.Find (old) == i) {
+         uint32_t first = FindIp (old);
+         if (first < v_relations.size()) {
+            m_ipIndex.Set (old, first);
+         }
+         else {
+            m_ipIndex.Erase (old);
+         }
+      }
+      
+      // La nueva IP se indexa en esta relacion si es la primera que la tiene
+      uint32_t current = m_ipIndex.Find (ip);
+      if (current == AddressIndex::NOT_FOUND || i < current) {
+         m_ipIndex.Set (ip, i);
+      }
+   }
+}
+
+/**
+ *
+ */
+void RelationContainer::Write (void) {
+   Write (filePrefix + Commons::relationsRegistry);
+}
+
+/**
+ *
+ */
+void RelationContainer::Write (std::string fileName) {
+   uint32_t n = v_relations.size();
+   std::ofstream write(fileName.c_str(), std::ios::app);
+   for (uint32_t i = 0; i < n; i++) {
+      write << "-> MAC: " << v_relations[i].r_mac << " IP: " << v_relations[i].r_ip << std::endl;
+   }
+   n = addresses.GetSize();
+   for (uint32_t i = 0; m_sharedSize > 0 && i < n; i++) {
+      if (IsVisible (i)) {
+         write << "-> MAC: " << addresses.GetMac (i) << " IP: " << addresses.GetIp (i) << std::endl;
+      }
+   }
+   write << std::endl;
+   write.close();
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase ReservedContainer                                                 |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+ReservedContainer::ReservedContainer (void) : m_fingerprint (0) {
+}
+
+/**
+ *
+ */
+bool ReservedContainer::Add (Ipv4Address ip, double time) {
+   uint32_t i = m_index.Find (ip);
+   if (i == AddressIndex::NOT_FOUND) {
+      Reserved r (ip, time);
+      v_reserved.push_back (r);
+      m_index.Set (ip, v_reserved.size() - 1);
+      m_expiry.push (Expiry (time, ip.Get()));
+      m_fingerprint ^= GetHash (ip);
+      return true;
+   }
+   if (v_reserved[i].r_time < time) {
+      v_reserved[i].r_time = time;              //La entrada del heap se corrige cuando llegue a la cima
+   }
+   return false;
+}
+
+/**
+ * The last reserved node takes the place of the erased one
+ */
+void ReservedContainer::Erase (uint32_t index) {
+   uint32_t last = v_reserved.size() - 1;
+   m_fingerprint ^= GetHash (v_reserved[index].r_ip);
+   m_index.Erase (v_reserved[index].r_ip);
+   if (index != last) {
+      v_reserved[index] = v_reserved[last];
+      m_index.Set (v_reserved[index].r_ip, index);
+   }
+   v_reserved.pop_back ();
+}
+
+/**
+ *
+ */
+bool ReservedContainer::Exist (Ipv4Address ip) {
+   return m_index.Find (ip) != AddressIndex::NOT_FOUND;
+}
+
+/**
+ *
+ */
+void ReservedContainer::GetAddresses (std::vector<uint32_t> &addresses) {
+   addresses.clear ();
+   for (uint32_t i = 0; i < v_reserved.size (); i++) {
+      addresses.push_back (v_reserved[i].r_ip.Get ());
+   }
+   std::sort (addresses.begin (), addresses.end ());
+}
+
+/**
+ *
+ */
+uint64_t ReservedContainer::GetFingerprint (void) {
+   return m_fingerprint;
+}
+
+/**
+ *
+ */
+uint64_t ReservedContainer::GetHash (Ipv4Address ip) {
+   uint64_t x = ip.Get () + 0x9e3779b97f4a7c15ULL;
+   x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+   return x ^ (x >> 31);
+}
+
+/**
+ *
+ */
+Ipv4Address ReservedContainer::GetIp (uint32_t index) {
+   Ipv4Address ip;
+   ip.Set(v_reserved[index].r_ip.Get());
+   return ip;
+}
+
+/**
+ *
+ */
+uint32_t ReservedContainer::GetSize (void) {
+   return v_reserved.size();
+}
+
+
+/**
+ *
+ */
+double ReservedContainer::GetTime (uint32_t index) {
+   return v_reserved[index].r_time;
+}
+
+/**
+ *
+ */
+double ReservedContainer::GetTime (Ipv4Address ip) {
+   double time = 0;
+   uint32_t i = m_index.Find (ip);
+   if (i != AddressIndex::NOT_FOUND) {
+      time = v_reserved[i].r_time;
+   }
+   return time;
+}
+
+/**
+ *
+ */
+bool ReservedContainer::IsOlder (const Reserved &a, const Reserved &b) {
+   if (a.r_time != b.r_time) {
+      return a.r_time < b.r_time;
+   }
+   return a.r_ip.Get () < b.r_ip.Get ();
+}
+
+/**
+ *
+ */
+void ReservedContainer::Update (double time, std::vector<Ipv4Address> &expired) {
+   while (!m_expiry.empty() && time - m_expiry.top().first >= Commons::RESERVED_LIFETIME) {
+      Expiry top = m_expiry.top();
+      m_expiry.pop();
+      uint32_t i = m_index.Find (Ipv4Address (top.second));
+      if (i == AddressIndex::NOT_FOUND) {
+         continue;                                              //La IP ya habia sido eliminada
+      }
+      double reservedTime = v_reserved[i].r_time;
+      if (time - reservedTime >= Commons::RESERVED_LIFETIME) {
+         expired.push_back (v_reserved[i].r_ip);
+         Erase (i);                                             //La reserva expiro
+      }
+      else {
+         m_expiry.push (Expiry (reservedTime, top.second));     //La reserva fue refrescada
+      }
+   }
+}
+
+/**
+ *
+ */
+void ReservedContainer::Write (void) {
+   Write (filePrefix + Commons::reservedRegistry);
+}
+
+/**
+ * Erase moves the last reserved node, so the vector is not in the order
+ * the nodes were reserved. The nodes are written from the oldest to the
+ * newest, which does not depend on the order of the erases
+ */
+void ReservedContainer::Write (std::string fileName) {
+   std::vector<Reserved> reserved (v_reserved);
+   std::sort (reserved.begin(), reserved.end(), &ReservedContainer::IsOlder);
+   uint32_t n = reserved.size();
+   std::ofstream write(fileName.c_str(), std::ios::app);
+   for (uint32_t i = 0; i < n; i++) {
+      write << "-> IP: " << reserved[i].r_ip << " TIME: " << reserved[i].r_time << std::endl;
+   }
+   write << std::endl;
+   write.close();
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase RoutingTableContainer                                             |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+RoutingTableContainer::RoutingTableContainer (void) {
+}
+
+/**
+ *
+ */
+void RoutingTableContainer::AddEntry (Ipv4Address dest, Ipv4Address next, uint32_t interface, uint32_t distance) {
+   RoutingTableEntry entry;
+   entry.destAddr = dest;
+   entry.nextAddr = next;
+   entry.interface = interface;
+   entry.distance = distance;
+   uint32_t i = m_index.Find (dest);
+   if (i != AddressIndex::NOT_FOUND) {
+      v_entries[i] = entry;
+   }
+   else {
+      m_index.Set (dest, v_entries.size ());
+      v_entries.push_back (entry);
+   }
+}
+
+/**
+ *
+ */
+void RoutingTableContainer::AddHnaRoute (Ipv4Address network, Ipv4Mask netmask, Ipv4Address next, uint32_t interface, uint32_t metric) {
+   HnaRoute route (network, netmask, next, interface, metric);
+   v_hnaRoutes.push_back (route);
+}
+
+/**
+ * Each route of OLSR is looked up in the index of this table, and the
+ * routes that were not found there are inserted at the end. The HNA table
+ * is only rebuilt if one of its routes changed
+ */
+bool RoutingTableContainer::Apply (Ptr<olsr::RoutingProtocol> olsr) {
+   bool changed = false;
+   std::map<Ipv4Address, RoutingTableEntry> &table = olsr->m_table;
+   v_applied.assign (v_entries.size (), false);
+   uint32_t applied = 0;
+   std::map<Ipv4Address, RoutingTableEntry>::iterator it = table.begin ();
+   while (it != table.end ()) {
+      uint32_t i = m_index.Find (it->first);
+      if (i == AddressIndex::NOT_FOUND) {
+         table.erase (it++);                                    //Ruta eliminada
+         changed = true;
+         continue;
+      }
+      if (!Equal (it->second, v_entries[i])) {
+         it->second = v_entries[i];                             //Ruta modificada
+         changed = true;
+      }
+      v_applied[i] = true;
+      applied += 1;
+      ++it;
+   }
+   for (uint32_t i = 0; applied < v_entries.size () && i < v_entries.size (); i++) {
+      if (!v_applied[i]) {
+         table.insert (std::make_pair (v_entries[i].destAddr, v_entries[i]));      //Ruta nueva
+         applied += 1;
+      }
+   }
+   if (ApplyHnaRoutes (olsr->m_hnaRoutingTable)) {
+      changed = true;
+   }
+   return changed;
+}
+
+/**
+ *
+ */
+bool RoutingTableContainer::ApplyHnaRoutes (Ptr<Ipv4StaticRouting> hnaRoutingTable) {
+   uint32_t n = v_hnaRoutes.size ();
+   bool equal = (hnaRoutingTable->GetNRoutes () == n);
+   for (uint32_t i = 0; equal && i < n; i++) {
+      Ipv4RoutingTableEntry route = hnaRoutingTable->GetRoute (i);
+      equal = route.GetDestNetwork () == v_hnaRoutes[i].h_network 
+              && route.GetDestNetworkMask () == v_hnaRoutes[i].h_netmask 
+              && route.GetGateway () == v_hnaRoutes[i].h_nextAddr 
+              && route.GetInterface () == v_hnaRoutes[i].h_interface 
+              && hnaRoutingTable->GetMetric (i) == v_hnaRoutes[i].h_metric;
+   }
+   if (equal) {
+      return false;
+   }
+   while (hnaRoutingTable->GetNRoutes () > 0) {
+      hnaRoutingTable->RemoveRoute (0);
+   }
+   for (uint32_t i = 0; i < n; i++) {
+      hnaRoutingTable->AddNetworkRouteTo (v_hnaRoutes[i].h_network, v_hnaRoutes[i].h_netmask, v_hnaRoutes[i].h_nextAddr, v_hnaRoutes[i].h_interface, v_hnaRoutes[i].h_metric);
+   }
+   return true;
+}
+
+/**
+ *
+ */
+void RoutingTableContainer::Clear (void) {
+   for (uint32_t i = 0; i < v_entries.size (); i++) {
+      m_index.Erase (v_entries[i].destAddr);
+   }
+   v_entries.clear ();
+   v_hnaRoutes.clear ();
+}
+
+/**
+ *
+ */
+bool RoutingTableContainer::Equal (const RoutingTableEntry &a, const RoutingTableEntry &b) {
+   return a.destAddr == b.destAddr && a.nextAddr == b.nextAddr && a.interface == b.interface && a.distance == b.distance;
+}
+
+/**
+ *
+ */
+uint32_t RoutingTableContainer::FindHnaRoute (Ipv4Address network, Ipv4Mask netmask) {
+   uint32_t n = v_hnaRoutes.size ();
+   uint32_t i = 0;
+   while (i < n && !(v_hnaRoutes[i].h_network == network && v_hnaRoutes[i].h_netmask == netmask)) {
+      i += 1;
+   }
+   return i;
+}
+
+/**
+ *
+ */
+const RoutingTableEntry &RoutingTableContainer::GetEntry (uint32_t index) {
+   return v_entries[index];
+}
+
+/**
+ *
+ */
+uint32_t RoutingTableContainer::GetHnaMetric (uint32_t index) {
+   return v_hnaRoutes[index].h_metric;
+}
+
+/**
+ *
+ */
+uint32_t RoutingTableContainer::GetNHnaRoutes (void) {
+   return v_hnaRoutes.size ();
+}
+
+/**
+ *
+ */
+uint32_t RoutingTableContainer::GetSize (void) {
+   return v_entries.size ();
+}
+
+/**
+ *
+ */
+bool RoutingTableContainer::Lookup (Ipv4Address dest, RoutingTableEntry &entry) {
+   uint32_t i = m_index.Find (dest);
+   if (i == AddressIndex::NOT_FOUND) {
+      return false;
+   }
+   entry = v_entries[i];
+   return true;
+}
+
+/**
+ * The last route takes the place of the removed one
+ */
+void RoutingTableContainer::RemoveEntry (Ipv4Address dest) {
+   uint32_t index = m_index.Find (dest);
+   if (index == AddressIndex::NOT_FOUND) {
+      return;
+   }
+   uint32_t last = v_entries.size () - 1;
+   m_index.Erase (dest);
+   if (index != last) {
+      v_entries[index] = v_entries[last];
+      m_index.Set (v_entries[index].destAddr, index);
+   }
+   v_entries.pop_back ();
+}
+
+/**
+ *
+ */
+void RoutingTableContainer::RemoveHnaRoute (uint32_t index) {
+   v_hnaRoutes.erase (v_hnaRoutes.begin () + index);
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase ForwardingTable                                                   |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+TypeId ForwardingTable::GetTypeId (void) {
+   static TypeId tid = TypeId ("ForwardingTable")
+      .SetParent<Ipv4RoutingProtocol> ()
+      .AddConstructor<ForwardingTable> ();
+   return tid;
+}
+
+/**
+ *
+ */
+ForwardingTable::ForwardingTable (void) {
+}
+
+/**
+ *
+ */
+void ForwardingTable::DoDispose (void) {
+   m_olsr = 0;
+   m_ipv4 = 0;
+   Ipv4RoutingProtocol::DoDispose ();
+}
+
+/**
+ * Same checks as RoutingProtocol::RouteOutput and RouteInput, except that
+ * any failure leaves the packet to OLSR instead of stopping the simulation
+ */
+Ptr<Ipv4Route> ForwardingTable::GetRoute (Ipv4Address destination, Ptr<const NetDevice> oif) {
+   RoutingTableEntry entry;
+   if (!m_routes.Lookup (destination, entry)) {
+      return Ptr<Ipv4Route> ();
+   }
+   while (entry.destAddr != entry.nextAddr) {
+      if (!m_routes.Lookup (entry.nextAddr, entry)) {
+         return Ptr<Ipv4Route> ();                                      //Sin entrada de envio
+      }
+   }
+   uint32_t interface = entry.interface;
+   if (oif && m_ipv4->GetInterfaceForDevice (oif) != static_cast<int> (interface)) {
+      return Ptr<Ipv4Route> ();                                         //La ruta no sale por la interfaz pedida
+   }
+   if (m_ipv4->GetNAddresses (interface) != 1) {
+      return Ptr<Ipv4Route> ();                                         //OLSR no soporta alias IP
+   }
+   Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+   route->SetDestination (destination);
+   route->SetSource (m_ipv4->GetAddress (interface, 0).GetLocal ());
+   route->SetGateway (entry.nextAddr);
+   route->SetOutputDevice (m_ipv4->GetNetDevice (interface));
+   return route;
+}
+
+/**
+ *
+ */
+void ForwardingTable::Install (Ptr<olsr::RoutingProtocol> olsr) {
+   m_olsr = olsr;
+   olsr->TraceConnectWithoutContext ("RoutingTableChanged", MakeCallback (&ForwardingTable::Update, this));
+   Update (olsr->GetSize ());
+}
+
+/**
+ *
+ */
+void ForwardingTable::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address) {
+}
+
+/**
+ *
+ */
+void ForwardingTable::NotifyInterfaceDown (uint32_t interface) {
+}
+
+/**
+ *
+ */
+void ForwardingTable::NotifyInterfaceUp (uint32_t interface) {
+}
+
+/**
+ *
+ */
+void ForwardingTable::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address) {
+}
+
+/**
+ *
+ */
+void ForwardingTable::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const {
+   m_olsr->PrintRoutingTable (stream);
+}
+
+/**
+ * The packets sent by the node itself are consumed by OLSR, and the local
+ * delivery is done by OLSR or by the list routing
+ */
+bool ForwardingTable::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev, UnicastForwardCallback ucb, MulticastForwardCallback mcb, LocalDeliverCallback lcb, ErrorCallback ecb) {
+   if (m_olsr->IsMyOwnAddress (header.GetSource ())) {
+      return false;
+   }
+   if (m_ipv4->IsDestinationAddress (header.GetDestination (), m_ipv4->GetInterfaceForDevice (idev))) {
+      return false;
+   }
+   Ptr<Ipv4Route> route = GetRoute (header.GetDestination (), Ptr<const NetDevice> ());
+   if (!route) {
+      return false;
+   }
+   ucb (route, p, header);
+   return true;
+}
+
+/**
+ *
+ */
+Ptr<Ipv4Route> ForwardingTable::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr) {
+   Ptr<Ipv4Route> route = GetRoute (header.GetDestination (), oif);
+   if (route) {
+      sockerr = Socket::ERROR_NOTERROR;
+   }
+   return route;
+}
+
+/**
+ *
+ */
+void ForwardingTable::SetIpv4 (Ptr<Ipv4> ipv4) {
+   m_ipv4 = ipv4;
+}
+
+/**
+ * The table is copied whole: OLSR builds it again at each change, and Apply
+ * goes over it all anyway
+ */
+void ForwardingTable::Update (uint32_t size) {
+   m_routes.Clear ();
+   std::map<Ipv4Address, RoutingTableEntry>::const_iterator it;
+   for (it = m_olsr->m_table.begin (); it != m_olsr->m_table.end (); it++) {
+      m_routes.AddEntry (it->second.destAddr, it->second.nextAddr, it->second.interface, it->second.distance);
+   }
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase TransmissionInfoContainer                                         |
+ * +-------------------------------------------------------------------------+
+ */
+
+
+/**
+ *
+ */
+TransmissionInfoContainer::TransmissionInfoContainer () : 
+   m_capacity (Commons::TRANSMISSION_CAPACITY), 
+   m_lifetime (Commons::TRANSMISSION_LIFETIME) 
+{
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::Add (Ipv4Address ip, double time) {
+   if (!Exist (ip)) {
+      if (m_capacity > 0 && v_transmissions.size() >= m_capacity) {
+         EraseOldest ();
+      }
+      TransmissionInfo t (ip, time);
+      v_transmissions.push_back (t);
+      m_index.Set (ip, v_transmissions.size() - 1);
+      m_ages.push (Age (time, ip.Get()));
+   }
+   else {
+      Update (ip, time);
+   }
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::Erase (Ipv4Address ip) {
+   uint32_t i = m_index.Find (ip);
+   if (i != AddressIndex::NOT_FOUND) {
+      EraseAt (i);
+   }
+}
+
+/**
+ * The last transmission takes the place of the erased one
+ */
+void TransmissionInfoContainer::EraseAt (uint32_t index) {
+   uint32_t last = v_transmissions.size() - 1;
+   m_index.Erase (v_transmissions[index].t_dstIp);
+   if (index != last) {
+      v_transmissions[index] = v_transmissions[last];
+      m_index.Set (v_transmissions[index].t_dstIp, index);
+   }
+   v_transmissions.pop_back ();
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::EraseOldest (void) {
+   while (!m_ages.empty()) {
+      Age top = m_ages.top();
+      m_ages.pop();
+      uint32_t i = m_index.Find (Ipv4Address (top.second));
+      if (i == AddressIndex::NOT_FOUND) {
+         continue;                                              //La transmision ya habia sido eliminada
+      }
+      double time = v_transmissions[i].t_time;
+      if (time == top.first) {
+         EraseAt (i);
+         return;
+      }
+      m_ages.push (Age (time, top.second));                     //La transmision fue actualizada
+   }
+}
+
+/**
+ *
+ */
+bool TransmissionInfoContainer::Exist (Ipv4Address ip) {
+   return m_index.Find (ip) != AddressIndex::NOT_FOUND;
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::Expire (double time) {
+   if (m_lifetime <= 0) {
+      return;
+   }
+   while (!m_ages.empty() && time - m_ages.top().first >= m_lifetime) {
+      Age top = m_ages.top();
+      m_ages.pop();
+      uint32_t i = m_index.Find (Ipv4Address (top.second));
+      if (i == AddressIndex::NOT_FOUND) {
+         continue;                                              //La transmision ya habia sido eliminada
+      }
+      double lastTime = v_transmissions[i].t_time;
+      if (time - lastTime >= m_lifetime) {
+         EraseAt (i);                                           //La transmision expiro
+      }
+      else {
+         m_ages.push (Age (lastTime, top.second));              //La transmision fue actualizada
+      }
+   }
+}
+
+/**
+ *
+ */
+uint32_t TransmissionInfoContainer::GetSize (void) {
+   return v_transmissions.size();
+}
+
+/**
+ *
+ */
+double TransmissionInfoContainer::GetTime (Ipv4Address ip) {
+   double time = 0;
+   uint32_t i = m_index.Find (ip);
+   if (i != AddressIndex::NOT_FOUND) {
+      time = v_transmissions[i].t_time;
+   }
+   return time;
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::SetCapacity (uint32_t capacity) {
+   m_capacity = capacity;
+   while (m_capacity > 0 && v_transmissions.size() > m_capacity) {
+      EraseOldest ();
+   }
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::SetLifetime (double lifetime) {
+   m_lifetime = lifetime;
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::Update (Ipv4Address ip, double time) {
+   uint32_t i = m_index.Find (ip);
+   if (i != AddressIndex::NOT_FOUND && v_transmissions[i].t_time < time) {
+      v_transmissions[i].t_time = time;                 //La entrada del heap se corrige cuando llegue a la cima
+   }
+}
+
+/**
+ *
+ */
+void TransmissionInfoContainer::Write (void) {
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase FrameDecoder                                                      |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ * Only the first bytes of the frame are copied into a local buffer
+ * (Packet::CopyData), and the offsets of each header are computed from
+ * the IEEE 802.11, LLC/SNAP, IPv4 and UDP formats. The Frame Control
+ * field is copied first, and the rest of the headers only for the data
+ * frames that carry data; the other frames copy up to Addr2.
+ */
+FrameClass FrameDecoder::Decode (Ptr<const Packet> packet, FrameInfo &info) {
+   uint8_t buffer[HEADER_BYTES];                                //Primeros bytes de la trama
+   if (packet->CopyData (buffer, 2) < 2) {      //La trama no contiene el campo Frame Control
+      return FRAME_MALFORMED;
+   }
+   
+   /* WifiMac Header */
+   uint8_t type = (buffer[0] >> 2) & 0x03;      //Tipo de la trama (0: administracion, 1: control, 2: datos)
+   uint8_t subtype = (buffer[0] >> 4) & 0x0f;   //Subtipo de la trama
+   if (type == 1) {                             //ACK y demas tramas de control
+      return FRAME_CONTROL;
+   }
+   if (type != 0 && type != 2) {                //Tipo reservado
+      return FRAME_MALFORMED;
+   }
+   bool data = (type == 2 && !(subtype & 0x04));                //Trama de datos con cuerpo (no Null, QoS Null, CF-Ack, ...)
+   uint32_t size = packet->CopyData (buffer, data ? HEADER_BYTES : 16);  //Cantidad de bytes leidos
+   if (size < 16) {                             //La trama no contiene Addr1 y Addr2
+      return FRAME_MALFORMED;
+   }
+   info.f_dstMac.CopyFrom (buffer + 4);         //Destination Address (Addr1)
+   info.f_srcMac.CopyFrom (buffer + 10);        //Source Address (Addr2)
+   if (type == 0) {
+      return FRAME_MANAGEMENT;
+   }
+   if (!data) {                                 //Subtipos sin datos (Null, QoS Null, CF-Ack, ...)
+      return FRAME_NON_IPV4;
+   }
+   uint32_t offset = 24;                        //Tamaño de la cabecera WifiMAC con tres direcciones
+   if ((buffer[1] & 0x03) == 0x03) {            //ToDS y FromDS: la cabecera contiene la cuarta direccion
+      offset += 6;
+   }
+   if (subtype & 0x08) {                        //Subtipo QoS: la cabecera contiene el campo QoS Control
+      offset += 2;
+   }
+   
+   /* LLC/SNAP Header */
+   if (size < offset + 8 || buffer[offset] != 0xaa || buffer[offset + 1] != 0xaa) {
+      return FRAME_MALFORMED;
+   }
+   uint16_t etherType = (buffer[offset + 6] << 8) | buffer[offset + 7];
+   offset += 8;
+   if (etherType != 0x0800) {                   //Si el paquete no es IPv4 (por ejemplo, ARP)
+      return FRAME_NON_IPV4;
+   }
+   
+   /* IPv4 Header */
+   if (size < offset + 20 || (buffer[offset] >> 4) != 4) {
+      return FRAME_MALFORMED;
+   }
+   uint32_t ipHeaderSize = (buffer[offset] & 0x0f) * 4;         //Tamaño de la cabecera IPv4 (IHL)
+   if (buffer[offset + 9] != 17) {                              //Si el protocolo transportado no es UDP
+      return FRAME_NON_UDP;
+   }
+   uint32_t ipOffset = offset;
+   offset += ipHeaderSize;
+   
+   /* UDP Header */
+   if (size < offset + 8) {
+      return FRAME_MALFORMED;
+   }
+   info.f_srcIp = Ipv4Address::Deserialize (buffer + ipOffset + 12);    //Direccion IP origen de la transmision
+   info.f_dstIp = Ipv4Address::Deserialize (buffer + ipOffset + 16);    //Direccion IP destino de la transmision
+   info.f_dstPort = (buffer[offset + 2] << 8) | buffer[offset + 3];     //Puerto UDP destino
+   return (info.f_dstPort == Commons::OLSR_PORT) ? FRAME_OLSR : FRAME_DATA;
+}
+
+/**
+ *
+ */
+bool FrameDecoder::DecodeTransmitter (Ptr<const Packet> packet, Mac48Address &transmitter) {
+   uint8_t buffer[16];                                  //Frame Control, Duration, Addr1 y Addr2
+   if (packet->CopyData (buffer, 16) < 16) {
+      return false;
+   }
+   if (((buffer[0] >> 2) & 0x03) == 1) {                //Las tramas de control no se guardan en el tap
+      return false;
+   }
+   transmitter.CopyFrom (buffer + 10);
+   return true;
+}
+
+/**
+ *
+ */
+std::string FrameDecoder::GetClassName (FrameClass frameClass) {
+   switch (frameClass) {
+      case FRAME_CONTROL:    return "Control";
+      case FRAME_MANAGEMENT: return "Management";
+      case FRAME_NON_IPV4:   return "NonIPv4";
+      case FRAME_NON_UDP:    return "NonUDP";
+      case FRAME_MALFORMED:  return "Malformed";
+      case FRAME_OLSR:       return "OLSR";
+      case FRAME_DATA:       return "Data";
+      default:               return "Unknown";
+   }
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase FrameFilter                                                       |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+FrameFilter::FrameFilter (void) {
+   Clear ();
+}
+
+/**
+ *
+ */
+bool FrameFilter::AcceptReceived (FrameClass frameClass) {
+   bool accept = (frameClass == FRAME_OLSR || frameClass == FRAME_DATA);
+   if (accept) {
+      f_rxAccepted[frameClass] += 1;
+   }
+   else {
+      f_rxRejected[frameClass] += 1;
+   }
+   return accept;
+}
+
+/**
+ *
+ */
+bool FrameFilter::AcceptSent (FrameClass frameClass) {
+   bool accept = (frameClass == FRAME_DATA);
+   if (accept) {
+      f_txAccepted[frameClass] += 1;
+   }
+   else {
+      f_txRejected[frameClass] += 1;
+   }
+   return accept;
+}
+
+/**
+ *
+ */
+void FrameFilter::Clear (void) {
+   for (uint32_t i = 0;i < FRAME_CLASSES;i += 1) {
+      f_rxAccepted[i] = 0;
+      f_rxRejected[i] = 0;
+      f_txAccepted[i] = 0;
+      f_txRejected[i] = 0;
+   }
+}
+
+/**
+ *
+ */
+void FrameFilter::Write (void) {
+   std::ofstream write((filePrefix + Commons::filterRegistry).c_str());
+   write << "Class"      << Commons::csvSymbol 
+         << "RxAccepted" << Commons::csvSymbol 
+         << "RxRejected" << Commons::csvSymbol 
+         << "TxAccepted" << Commons::csvSymbol 
+         << "TxRejected" << std::endl;
+   for (uint32_t i = 0;i < FRAME_CLASSES;i += 1) {
+      write << FrameDecoder::GetClassName ((FrameClass) i) << Commons::csvSymbol 
+            << f_rxAccepted[i] << Commons::csvSymbol 
+            << f_rxRejected[i] << Commons::csvSymbol 
+            << f_txAccepted[i] << Commons::csvSymbol 
+            << f_txRejected[i] << std::endl;
+   }
+   write.close();
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase FrameTap                                                          |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+FrameTap::FrameTap (void) : m_decoded (0), m_hits (0), m_misses (0) {
+}
+
+/**
+ *
+ */
+void FrameTap::Clear (void) {
+   m_entries.clear ();
+   m_order.clear ();
+   m_decoded = 0;
+   m_hits = 0;
+   m_misses = 0;
+}
+
+/**
+ *
+ */
+void FrameTap::Expire (double now) {
+   while (!m_order.empty () && now - m_order.front ().first > Commons::FRAME_TAP_LIFETIME) {
+      std::map<TapKey, TapEntry>::iterator it = m_entries.find (m_order.front ().second);
+      if (it != m_entries.end () && it->second.t_time == m_order.front ().first) {      //Si la transmision no fue repetida despues
+         m_entries.erase (it);
+      }
+      m_order.pop_front ();
+   }
+}
+
+/**
+ *
+ */
+FrameTap::TapKey FrameTap::GetKey (uint64_t uid, Mac48Address transmitter) {
+   return TapKey (uid, AddressTable::GetKey (transmitter));
+}
+
+/**
+ *
+ */
+FrameClass FrameTap::Receive (Ptr<const Packet> packet, FrameInfo &info) {
+   Mac48Address transmitter;
+   if (!FrameDecoder::DecodeTransmitter (packet, transmitter)) {        //ACK y demas tramas de control
+      return FrameDecoder::Decode (packet, info);
+   }
+   std::map<TapKey, TapEntry>::const_iterator it = m_entries.find (GetKey (packet->GetUid (), transmitter));
+   if (it != m_entries.end ()) {
+      m_hits += 1;
+      info = it->second.t_info;
+      return it->second.t_class;
+   }
+   m_misses += 1;
+   return FrameDecoder::Decode (packet, info);
+}
+
+/**
+ *
+ */
+FrameClass FrameTap::Transmit (Ptr<const Packet> packet, FrameInfo &info) {
+   FrameClass frameClass = FrameDecoder::Decode (packet, info);
+   if (frameClass != FRAME_CONTROL) {                           //Las tramas de control no se guardan
+      double now = Simulator::Now ().GetSeconds ();
+      Expire (now);
+      TapKey key = GetKey (packet->GetUid (), info.f_srcMac);
+      TapEntry &entry = m_entries[key];
+      entry.t_class = frameClass;
+      entry.t_info = info;
+      entry.t_time = now;
+      m_order.push_back (std::make_pair (now, key));
+      m_decoded += 1;
+   }
+   return frameClass;
+}
+
+/**
+ *
+ */
+void FrameTap::Write (void) {
+   std::ofstream write((filePrefix + Commons::tapRegistry).c_str());
+   write << "Decoded" << Commons::csvSymbol 
+         << "Reused"  << Commons::csvSymbol 
+         << "Redecoded" << std::endl;
+   write << m_decoded << Commons::csvSymbol 
+         << m_hits << Commons::csvSymbol 
+         << m_misses << std::endl;
+   write.close();
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase MprCalculator                                                     |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+MprCalculator::MprCalculator (void) : m_words (0) {
+}
+
+/**
+ * Follows the steps of MprComputation. As there, selecting a neighbor in
+ * the steps 1 and 4 removes from N2 only the pairs of that neighbor, and
+ * the step 3 removes the pairs of every 2-hop neighbor it covered. In the
+ * step 4 the neighbor with the highest (willingness, reachability, D(y))
+ * is selected, the first one in the order of N among equal ones, which is
+ * the neighbor MprComputation ends up with
+ */
+void MprCalculator::Compute (Ptr<olsr::RoutingProtocol> olsr) {
+   m_olsr = olsr;
+   OlsrState &state = olsr->m_state;
+   
+   /* N: vecinos simetricos */
+   v_neighbors.clear ();
+   m_neighborIndex.Clear ();
+   const olsr::NeighborSet &neighbors = state.GetNeighbors ();
+   for (olsr::NeighborSet::const_iterator it = neighbors.begin (); it != neighbors.end (); it++) {
+      if (it->status == olsr::NeighborTuple::STATUS_SYM) {
+         if (m_neighborIndex.Find (it->neighborMainAddr) == AddressIndex::NOT_FOUND) {
+            m_neighborIndex.Set (it->neighborMainAddr, v_neighbors.size ());
+         }
+         v_neighbors.push_back (&(*it));
+      }
+   }
+   
+   /* N2: vecinos a 2 saltos, sin el nodo, sin los alcanzables solo por vecinos WILL_NEVER y sin los vecinos simetricos */
+   v_pairs.clear ();
+   m_twoHopIndex.Clear ();
+   uint32_t twoHopNeighbors = 0;
+   const olsr::TwoHopNeighborSet &twoHops = state.GetTwoHopNeighbors ();
+   for (olsr::TwoHopNeighborSet::const_iterator it = twoHops.begin (); it != twoHops.end (); it++) {
+      if (it->twoHopNeighborAddr == olsr->m_mainAddress) {
+         continue;
+      }
+      uint32_t neighbor = m_neighborIndex.Find (it->neighborMainAddr);
+      if (neighbor == AddressIndex::NOT_FOUND || v_neighbors[neighbor]->willingness == OLSR_WILL_NEVER) {
+         continue;
+      }
+      if (m_neighborIndex.Find (it->twoHopNeighborAddr) != AddressIndex::NOT_FOUND) {
+         continue;
+      }
+      uint32_t twoHop = m_twoHopIndex.Find (it->twoHopNeighborAddr);
+      if (twoHop == AddressIndex::NOT_FOUND) {
+         twoHop = twoHopNeighbors++;
+         m_twoHopIndex.Set (it->twoHopNeighborAddr, twoHop);
+      }
+      v_pairs.push_back (std::make_pair (neighbor, twoHop));
+   }
+   
+   m_words = (twoHopNeighbors + 63) / 64;
+   v_cover.assign (v_neighbors.size () * m_words, 0);
+   for (uint32_t i = 0; i < v_pairs.size (); i++) {
+      GetCover (v_pairs[i].first)[v_pairs[i].second / 64] |= (uint64_t) 1 << (v_pairs[i].second % 64);
+   }
+   v_degrees.assign (v_neighbors.size (), -1);
+   
+   olsr::MprSet mprSet;
+   
+   /* 1. Los vecinos con voluntad WILL_ALWAYS */
+   for (uint32_t i = 0; i < v_neighbors.size (); i++) {
+      if (v_neighbors[i]->willingness == OLSR_WILL_ALWAYS) {
+         mprSet.insert (v_neighbors[i]->neighborMainAddr);
+         RemoveCover (i);
+      }
+   }
+   
+   /* 3. Los vecinos que son los unicos que alcanzan algun vecino a 2 saltos */
+   v_once.assign (m_words, 0);
+   v_twice.assign (m_words, 0);
+   for (uint32_t i = 0; i < v_neighbors.size (); i++) {
+      uint64_t *cover = GetCover (i);
+      for (uint32_t w = 0; w < m_words; w++) {
+         v_twice[w] |= v_once[w] & cover[w];
+         v_once[w] |= cover[w];
+      }
+   }
+   v_covered.assign (m_words, 0);
+   for (uint32_t i = 0; i < v_neighbors.size (); i++) {
+      uint64_t *cover = GetCover (i);
+      bool onlyOne = false;
+      for (uint32_t w = 0; w < m_words && !onlyOne; w++) {
+         onlyOne = (cover[w] & v_once[w] & ~v_twice[w]) != 0;
+      }
+      if (onlyOne) {
+         mprSet.insert (v_neighbors[i]->neighborMainAddr);
+         for (uint32_t w = 0; w < m_words; w++) {
+            v_covered[w] |= cover[w];
+         }
+      }
+   }
+   for (uint32_t i = 0; i < v_neighbors.size (); i++) {
+      uint64_t *cover = GetCover (i);
+      for (uint32_t w = 0; w < m_words; w++) {
+         cover[w] &= ~v_covered[w];
+      }
+   }
+   
+   /* 4. Mientras queden vecinos a 2 saltos sin cubrir */
+   while (true) {
+      uint32_t max = AddressIndex::NOT_FOUND;       //Vecino seleccionado
+      uint32_t maxReachability = 0;
+      for (uint32_t i = 0; i < v_neighbors.size (); i++) {
+         uint32_t reachability = GetReachability (i);
+         if (reachability == 0) {
+            continue;
+         }
+         bool better = max == AddressIndex::NOT_FOUND || v_neighbors[i]->willingness > v_neighbors[max]->willingness;
+         if (!better && v_neighbors[i]->willingness == v_neighbors[max]->willingness) {
+            better = reachability > maxReachability || (reachability == maxReachability && GetDegree (i) > GetDegree (max));
+         }
+         if (better) {
+            max = i;
+            maxReachability = reachability;
+         }
+      }
+      if (max == AddressIndex::NOT_FOUND) {
+         break;                                     //N2 quedo vacio
+      }
+      mprSet.insert (v_neighbors[max]->neighborMainAddr);
+      RemoveCover (max);
+   }
+   
+   state.SetMprSet (mprSet);
+}
+
+/**
+ *
+ */
+uint64_t *MprCalculator::GetCover (uint32_t neighbor) {
+   return v_cover.data () + neighbor * m_words;
+}
+
+/**
+ *
+ */
+int MprCalculator::GetDegree (uint32_t neighbor) {
+   if (v_degrees[neighbor] < 0) {
+      v_degrees[neighbor] = m_olsr->Degree (*v_neighbors[neighbor]);
+   }
+   return v_degrees[neighbor];
+}
+
+/**
+ *
+ */
+uint32_t MprCalculator::GetReachability (uint32_t neighbor) {
+   uint64_t *cover = GetCover (neighbor);
+   uint32_t reachability = 0;
+   for (uint32_t w = 0; w < m_words; w++) {
+      reachability += __builtin_popcountll (cover[w]);
+   }
+   return reachability;
+}
+
+/**
+ *
+ */
+void MprCalculator::RemoveCover (uint32_t neighbor) {
+   uint64_t *cover = GetCover (neighbor);
+   for (uint32_t w = 0; w < m_words; w++) {
+      cover[w] = 0;
+   }
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase OlsrTupleIndex                                                    |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+OlsrTupleIndex::OlsrTupleIndex (void) : m_duplicateCount (0), m_topologyCount (0) {
+}
+
+/**
+ * A tuple whose key is already indexed keeps the position of the first
+ * one, as FindDuplicateTuple returns the first tuple
+ */
+void OlsrTupleIndex::AddDuplicateTuple (const olsr::DuplicateTuple &tuple) {
+   Check ();
+   m_olsr->AddDuplicateTuple (tuple);
+   m_duplicates.insert (std::make_pair (GetKey (tuple.address, tuple.sequenceNumber), m_duplicateCount));
+   m_duplicateCount += 1;
+}
+
+/**
+ *
+ */
+void OlsrTupleIndex::AddTopologyTuple (const olsr::TopologyTuple &tuple) {
+   Check ();
+   m_olsr->AddTopologyTuple (tuple);
+   if (m_topology.insert (std::make_pair (GetKey (tuple.destAddr, tuple.lastAddr), m_topologyCount)).second) {
+      m_lastAddresses[tuple.lastAddr.Get ()].push_back (tuple.destAddr);
+   }
+   m_topologyCount += 1;
+}
+
+/**
+ * The protocol does not change the sets while the receiver is installed,
+ * so the index is only built at the first lookup
+ */
+void OlsrTupleIndex::Check (void) {
+   DuplicateSet &duplicates = m_olsr->m_state.GetDuplicateSet ();
+   if (duplicates.size () != m_duplicateCount) {
+      m_duplicates.clear ();
+      for (uint32_t i = 0; i < duplicates.size (); i++) {
+         m_duplicates.insert (std::make_pair (GetKey (duplicates[i].address, duplicates[i].sequenceNumber), i));   //Se conserva la primera tupla de cada llave
+      }
+      m_duplicateCount = duplicates.size ();
+   }
+   
+   TopologySet &topology = m_olsr->m_state.GetTopologySet ();
+   if (topology.size () != m_topologyCount) {
+      m_topology.clear ();
+      std::unordered_map<uint32_t, std::vector<Ipv4Address> >::iterator it;
+      for (it = m_lastAddresses.begin (); it != m_lastAddresses.end (); it++) {
+         it->second.clear ();                                           //Los vectores se conservan para reutilizar su memoria
+      }
+      for (uint32_t i = 0; i < topology.size (); i++) {
+         if (m_topology.insert (std::make_pair (GetKey (topology[i].destAddr, topology[i].lastAddr), i)).second) {
+            m_lastAddresses[topology[i].lastAddr.Get ()].push_back (topology[i].destAddr);
+         }
+      }
+      m_topologyCount = topology.size ();
+   }
+}
+
+/**
+ * The set is only scanned, by the protocol, when the originator has an
+ * older tuple; the repeated TC messages of an originator, with the same
+ * ANSN, erase nothing
+ */
+void OlsrTupleIndex::EraseOlderTopologyTuples (const Ipv4Address &lastAddr, uint16_t ansn) {
+   Check ();
+   std::unordered_map<uint32_t, std::vector<Ipv4Address> >::iterator bucket = m_lastAddresses.find (lastAddr.Get ());
+   if (bucket == m_lastAddresses.end ()) {
+      return;
+   }
+   std::vector<Ipv4Address> older;                                      //Destinos de las tuplas anteriores
+   for (uint32_t i = 0; i < bucket->second.size (); i++) {
+      olsr::TopologyTuple *tuple = Locate (bucket->second[i], lastAddr);
+      if (tuple != NULL && tuple->sequenceNumber < ansn) {
+         older.push_back (tuple->destAddr);
+      }
+   }
+   if (older.empty ()) {
+      return;
+   }
+   m_olsr->m_state.EraseOlderTopologyTuples (lastAddr, ansn);
+   for (uint32_t i = 0; i < older.size (); i++) {
+      Unindex (older[i], lastAddr);
+   }
+   m_topologyCount -= older.size ();
+}
+
+/**
+ * The tuples erased since the last lookup of the tuple are usually the
+ * oldest ones, before it, so the tuple is found a few positions back
+ */
+olsr::DuplicateTuple *OlsrTupleIndex::FindDuplicateTuple (const Ipv4Address &address, uint16_t sequenceNumber) {
+   Check ();
+   std::unordered_map<uint64_t, uint32_t>::iterator it = m_duplicates.find (GetKey (address, sequenceNumber));
+   if (it == m_duplicates.end ()) {
+      return NULL;
+   }
+   DuplicateSet &duplicates = m_olsr->m_state.GetDuplicateSet ();
+   uint32_t position = std::min (it->second, m_duplicateCount - 1);
+   while (duplicates[position].address != address || duplicates[position].sequenceNumber != sequenceNumber) {
+      if (position == 0) {
+         m_duplicates.erase (it);                                       //La tupla ya no esta en el conjunto
+         return NULL;
+      }
+      position -= 1;                                                    //La tupla se movio hacia el inicio del conjunto
+   }
+   it->second = position;
+   return &duplicates[position];
+}
+
+/**
+ * Only the tuples of the originator are visited
+ */
+olsr::TopologyTuple *OlsrTupleIndex::FindNewerTopologyTuple (const Ipv4Address &lastAddr, uint16_t ansn) {
+   Check ();
+   std::unordered_map<uint32_t, std::vector<Ipv4Address> >::iterator bucket = m_lastAddresses.find (lastAddr.Get ());
+   if (bucket == m_lastAddresses.end ()) {
+      return NULL;
+   }
+   for (uint32_t i = 0; i < bucket->second.size (); i++) {
+      olsr::TopologyTuple *tuple = Locate (bucket->second[i], lastAddr);
+      if (tuple != NULL && tuple->sequenceNumber > ansn) {
+         return tuple;
+      }
+   }
+   return NULL;
+}
+
+/**
+ *
+ */
+olsr::TopologyTuple *OlsrTupleIndex::FindTopologyTuple (const Ipv4Address &destAddr, const Ipv4Address &lastAddr) {
+   Check ();
+   return Locate (destAddr, lastAddr);
+}
+
+/**
+ *
+ */
+uint64_t OlsrTupleIndex::GetKey (const Ipv4Address &address, uint16_t sequenceNumber) {
+   return ((uint64_t) address.Get () << 16) | sequenceNumber;
+}
+
+/**
+ *
+ */
+uint64_t OlsrTupleIndex::GetKey (const Ipv4Address &destAddr, const Ipv4Address &lastAddr) {
+   return ((uint64_t) destAddr.Get () << 32) | lastAddr.Get ();
+}
+
+/**
+ *
+ */
+void OlsrTupleIndex::Install (Ptr<olsr::RoutingProtocol> olsr) {
+   m_olsr = olsr;
+   m_duplicates.clear ();
+   m_duplicateCount = 0;
+   m_topology.clear ();
+   m_lastAddresses.clear ();
+   m_topologyCount = 0;
+}
+
+/**
+ * Same search as FindDuplicateTuple. The index is not changed when the
+ * tuple is not found, since the tuple is still in the bucket being visited
+ * by the caller
+ */
+olsr::TopologyTuple *OlsrTupleIndex::Locate (const Ipv4Address &destAddr, const Ipv4Address &lastAddr) {
+   std::unordered_map<uint64_t, uint32_t>::iterator it = m_topology.find (GetKey (destAddr, lastAddr));
+   if (it == m_topology.end ()) {
+      return NULL;
+   }
+   TopologySet &topology = m_olsr->m_state.GetTopologySet ();
+   uint32_t position = std::min (it->second, m_topologyCount - 1);
+   while (topology[position].destAddr != destAddr || topology[position].lastAddr != lastAddr) {
+      if (position == 0) {
+         return NULL;
+      }
+      position -= 1;
+   }
+   it->second = position;
+   return &topology[position];
+}
+
+/**
+ * The key is taken before the tuple is erased, since the tuple may be the
+ * one in the set
+ */
+void OlsrTupleIndex::RemoveDuplicateTuple (const olsr::DuplicateTuple &tuple) {
+   uint64_t key = GetKey (tuple.address, tuple.sequenceNumber);
+   Check ();
+   m_olsr->RemoveDuplicateTuple (tuple);
+   m_duplicates.erase (key);
+   m_duplicateCount -= 1;
+}
+
+/**
+ * The addresses are copied before the tuple is erased, since the tuple
+ * may be the one in the set
+ */
+void OlsrTupleIndex::RemoveTopologyTuple (const olsr::TopologyTuple &tuple) {
+   Ipv4Address destAddr = tuple.destAddr;
+   Ipv4Address lastAddr = tuple.lastAddr;
+   Check ();
+   m_olsr->RemoveTopologyTuple (tuple);
+   Unindex (destAddr, lastAddr);
+   m_topologyCount -= 1;
+}
+
+/**
+ * The order of the destinations of a bucket does not matter, so the
+ * destination is replaced by the last one
+ */
+void OlsrTupleIndex::Unindex (const Ipv4Address &destAddr, const Ipv4Address &lastAddr) {
+   m_topology.erase (GetKey (destAddr, lastAddr));
+   std::vector<Ipv4Address> &destinations = m_lastAddresses[lastAddr.Get ()];
+   for (uint32_t i = 0; i < destinations.size (); i++) {
+      if (destinations[i] == destAddr) {
+         destinations[i] = destinations.back ();
+         destinations.pop_back ();
+         return;
+      }
+   }
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase OlsrReceiver                                                      |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+OlsrReceiver::OlsrReceiver (void) : m_lazyDecoding (false), m_tracePackets (true), m_hookedSockets (0), m_messages (0), m_decodedMessages (0) {
+}
+
+/**
+ *
+ */
+void OlsrReceiver::CheckSockets (const olsr::PacketHeader &header, const olsr::MessageList &messages) {
+   if (m_olsr->m_socketAddresses.size () != m_hookedSockets) {
+      Hook ();
+   }
+}
+
+/**
+ * Same wire format read by MessageHeader::Deserialize. The validity time is
+ * set back from its mantissa-exponent value, which SetVTime encodes again
+ * without loss (the values are binary fractions of a second)
+ */
+bool OlsrReceiver::Decode (const uint8_t *data, uint32_t size, olsr::MessageHeader &message) {
+   if (!IsKnown (data[0])) {
+      return false;
+   }
+   message.SetMessageType (olsr::MessageHeader::MessageType (data[0]));
+   message.SetVTime (Seconds (olsr::EmfToSeconds (data[1])));
+   message.SetOriginatorAddress (Ipv4Address::Deserialize (data + 4));
+   message.SetTimeToLive (data[8]);
+   message.SetHopCount (data[9]);
+   message.SetMessageSequenceNumber (ReadU16 (data + 10));
+   
+   const uint8_t *body = data + MESSAGE_HEADER_BYTES;   //Cuerpo del mensaje
+   uint32_t bodySize = size - MESSAGE_HEADER_BYTES;     //Tamaño del cuerpo del mensaje
+   switch (data[0]) {
+      case olsr::MessageHeader::HELLO_MESSAGE:
+         return DecodeHello (body, bodySize, message.GetHello ());
+      case olsr::MessageHeader::TC_MESSAGE: {
+         if (bodySize < 4 || bodySize % 4 != 0) {
+            return false;
+         }
+         olsr::MessageHeader::Tc &tc = message.GetTc ();
+         tc.ansn = ReadU16 (body);
+         ReadAddresses (body + 4, (bodySize - 4) / 4, tc.neighborAddresses);
+         return true;
+      }
+      case olsr::MessageHeader::MID_MESSAGE: {
+         if (bodySize % 4 != 0) {
+            return false;
+         }
+         ReadAddresses (body, bodySize / 4, message.GetMid ().interfaceAddresses);
+         return true;
+      }
+      case olsr::MessageHeader::HNA_MESSAGE: {
+         if (bodySize % 8 != 0) {
+            return false;
+         }
+         std::vector<olsr::MessageHeader::Hna::Association> &associations = message.GetHna ().associations;
+         associations.resize (bodySize / 8);
+         for (uint32_t i = 0; i < associations.size (); i++) {
+            associations[i].address = Ipv4Address::Deserialize (body + 8 * i);
+            associations[i].mask = Ipv4Mask (ReadU32 (body + 8 * i + 4));
+         }
+         return true;
+      }
+   }
+   return false;
+}
+
+/**
+ * The link messages are counted first, so that the vector of link messages
+ * only changes its size when the number of them changes
+ */
+bool OlsrReceiver::DecodeHello (const uint8_t *body, uint32_t size, olsr::MessageHeader::Hello &hello) {
+   if (size < 4) {
+      return false;
+   }
+   uint32_t count = 0;                                  //Mensajes de enlace
+   for (uint32_t offset = 4; offset < size; count++) {
+      if (size - offset < 4) {
+         return false;
+      }
+      uint16_t linkSize = ReadU16 (body + offset + 2);
+      if (linkSize < 4 || linkSize % 4 != 0 || linkSize > size - offset) {
+         return false;
+      }
+      offset += linkSize;
+   }
+   
+   hello.hTime = body[2];
+   hello.willingness = body[3];
+   ResizeLinkMessages (hello.linkMessages, count);
+   uint32_t offset = 4;
+   for (uint32_t i = 0; i < count; i++) {
+      uint16_t linkSize = ReadU16 (body + offset + 2);
+      hello.linkMessages[i].linkCode = body[offset];
+      ReadAddresses (body + offset + 4, (linkSize - 4) / 4, hello.linkMessages[i].neighborInterfaceAddresses);
+      offset += linkSize;
+   }
+   return true;
+}
+
+/**
+ * Same as RoutingProtocol::ForwardDefault, except that the message is
+ * retransmitted by the caller and the expiration of a new duplicate tuple is
+ * checked by the TupleSweeper
+ */
+bool OlsrReceiver::Forward (const Ipv4Address &originator, uint16_t sequenceNumber, uint8_t ttl, olsr::DuplicateTuple *duplicated, const Ipv4Address &receiverIface, const Ipv4Address &senderIface) {
+   Time now = Simulator::Now ();
+   if (m_olsr->m_state.FindSymLinkTuple (senderIface, now) == NULL) {
+      return false;                                                     //El emisor no es un vecino simetrico
+   }
+   if (duplicated != NULL && duplicated->retransmitted) {
+      return false;                                                     //Ya fue retransmitido
+   }
+   
+   bool retransmitted = ttl > 1 && m_olsr->m_state.FindMprSelectorTuple (m_olsr->GetMainAddress (senderIface)) != NULL;
+   if (duplicated != NULL) {
+      duplicated->expirationTime = now + OLSR_DUP_HOLD_TIME;
+      duplicated->retransmitted = retransmitted;
+      duplicated->ifaceList.push_back (receiverIface);
+   }
+   else {
+      olsr::DuplicateTuple newDuplicated;
+      newDuplicated.address = originator;
+      newDuplicated.sequenceNumber = sequenceNumber;
+      newDuplicated.expirationTime = now + OLSR_DUP_HOLD_TIME;
+      newDuplicated.retransmitted = retransmitted;
+      newDuplicated.ifaceList.push_back (receiverIface);
+      m_tupleIndex.AddDuplicateTuple (newDuplicated);
+      m_sweeper.AddDuplicate (newDuplicated.address, newDuplicated.sequenceNumber, newDuplicated.expirationTime);
+   }
+   return retransmitted;
+}
+
+/**
+ *
+ */
+uint64_t OlsrReceiver::GetDecodedMessages (void) const {
+   return m_decodedMessages;
+}
+
+/**
+ *
+ */
+Time OlsrReceiver::GetJitter (void) {
+   return Seconds (UniformVariable ().GetValue (0, m_olsr->m_helloInterval.GetSeconds () / 4));   //JITTER del protocolo
+}
+
+/**
+ *
+ */
+uint64_t OlsrReceiver::GetMessages (void) const {
+   return m_messages;
+}
+
+/**
+ *
+ */
+const TupleSweeper &OlsrReceiver::GetSweeper (void) const {
+   return m_sweeper;
+}
+
+/**
+ *
+ */
+void OlsrReceiver::Hook (void) {
+   std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator it;
+   for (it = m_olsr->m_socketAddresses.begin (); it != m_olsr->m_socketAddresses.end (); ++it) {
+      it->first->SetRecvCallback (MakeCallback (&OlsrReceiver::Receive, this));
+   }
+   m_hookedSockets = m_olsr->m_socketAddresses.size ();
+}
+
+/**
+ *
+ */
+void OlsrReceiver::Install (Ptr<olsr::RoutingProtocol> olsr) {
+   m_olsr = olsr;
+   m_tupleIndex.Install (olsr);
+   m_sweeper.Install (olsr, &m_tupleIndex, MakeCallback (&OlsrReceiver::NeighborLoss, this));
+   olsr->TraceConnectWithoutContext ("Tx", MakeCallback (&OlsrReceiver::CheckSockets, this));   //Sockets creados despues del inicio
+   Simulator::Schedule (Seconds (0), &OlsrReceiver::Hook, this);   //Despues de que el protocolo crea sus sockets
+}
+
+/**
+ *
+ */
+bool OlsrReceiver::IsKnown (uint8_t type) {
+   return type >= olsr::MessageHeader::HELLO_MESSAGE && type <= olsr::MessageHeader::HNA_MESSAGE;
+}
+
+/**
+ *
+ */
+void OlsrReceiver::LazyDecoding (bool enable) {
+   m_lazyDecoding = enable;
+}
+
+/**
+ * Same steps as RoutingProtocol::LinkSensing, except that the expiration of
+ * a new link tuple is checked by the TupleSweeper
+ */
+void OlsrReceiver::LinkSensing (const olsr::MessageHeader &message, const olsr::MessageHeader::Hello &hello, const Ipv4Address &receiverIface, const Ipv4Address &senderIface) {
+   Time now = Simulator::Now ();
+   bool updated = false;
+   bool created = false;
+   
+   olsr::LinkTuple *linkTuple = m_olsr->m_state.FindLinkTuple (senderIface);
+   if (linkTuple == NULL) {
+      olsr::LinkTuple newLink;
+      newLink.neighborIfaceAddr = senderIface;
+      newLink.localIfaceAddr = receiverIface;
+      newLink.symTime = now - Seconds (1);
+      newLink.time = now + message.GetVTime ();
+      linkTuple = &m_olsr->m_state.InsertLinkTuple (newLink);
+      created = true;
+   }
+   else {
+      updated = true;
+   }
+   
+   linkTuple->asymTime = now + message.GetVTime ();
+   for (uint32_t i = 0; i < hello.linkMessages.size (); i++) {
+      const olsr::MessageHeader::Hello::LinkMessage &linkMessage = hello.linkMessages[i];
+      int linkType = linkMessage.linkCode & 0x03;
+      int neighborType = (linkMessage.linkCode >> 2) & 0x03;
+      if ((linkType == OLSR_SYM_LINK && neighborType == OLSR_NOT_NEIGH) || (neighborType != OLSR_SYM_NEIGH && neighborType != OLSR_MPR_NEIGH && neighborType != OLSR_NOT_NEIGH)) {
+         continue;                                                      //Codigo de enlace invalido
+      }
+      for (uint32_t j = 0; j < linkMessage.neighborInterfaceAddresses.size (); j++) {
+         if (linkMessage.neighborInterfaceAddresses[j] != receiverIface) {
+            continue;
+         }
+         if (linkType == OLSR_LOST_LINK) {
+            linkTuple->symTime = now - Seconds (1);
+            updated = true;
+         }
+         else if (linkType == OLSR_SYM_LINK || linkType == OLSR_ASYM_LINK) {
+            linkTuple->symTime = now + message.GetVTime ();
+            linkTuple->time = linkTuple->symTime + TimeStep (3 * m_olsr->m_helloInterval.GetTimeStep ());   //OLSR_NEIGHB_HOLD_TIME
+            updated = true;
+         }
+         else {
+            NS_FATAL_ERROR ("bad link type");
+         }
+         break;
+      }
+   }
+   linkTuple->time = std::max (linkTuple->time, linkTuple->asymTime);
+   
+   if (updated) {
+      m_olsr->LinkTupleUpdated (*linkTuple, hello.willingness);
+   }
+   if (created) {
+      m_olsr->LinkTupleAdded (*linkTuple, hello.willingness);
+      m_sweeper.AddLink (linkTuple->neighborIfaceAddr, std::min (linkTuple->time, linkTuple->symTime));
+   }
+}
+
+/**
+ *
+ */
+void OlsrReceiver::NeighborLoss (const olsr::LinkTuple &tuple) {
+   Ipv4Address neighbor = m_olsr->GetMainAddress (tuple.neighborIfaceAddr);
+   m_olsr->LinkTupleUpdated (tuple, OLSR_WILL_DEFAULT);
+   m_olsr->m_state.EraseTwoHopNeighborTuples (neighbor);
+   m_olsr->m_state.EraseMprSelectorTuples (neighbor);
+   m_mprCalculator.Compute (m_olsr);
+   m_olsr->RoutingTableComputation ();
+}
+
+/**
+ * Same steps as RoutingProtocol::PopulateMprSelectorSet, except that the
+ * expiration of a new MPR selector tuple is checked by the TupleSweeper
+ */
+void OlsrReceiver::PopulateMprSelectorSet (const olsr::MessageHeader &message, const olsr::MessageHeader::Hello &hello) {
+   Time now = Simulator::Now ();
+   for (uint32_t i = 0; i < hello.linkMessages.size (); i++) {
+      const olsr::MessageHeader::Hello::LinkMessage &linkMessage = hello.linkMessages[i];
+      if ((linkMessage.linkCode >> 2) != OLSR_MPR_NEIGH) {
+         continue;
+      }
+      for (uint32_t j = 0; j < linkMessage.neighborInterfaceAddresses.size (); j++) {
+         if (m_olsr->GetMainAddress (linkMessage.neighborInterfaceAddresses[j]) != m_olsr->m_mainAddress) {
+            continue;
+         }
+         olsr::MprSelectorTuple *mprSelector = m_olsr->m_state.FindMprSelectorTuple (message.GetOriginatorAddress ());
+         if (mprSelector != NULL) {
+            mprSelector->expirationTime = now + message.GetVTime ();
+         }
+         else {
+            olsr::MprSelectorTuple newMprSelector;
+            newMprSelector.mainAddr = message.GetOriginatorAddress ();
+            newMprSelector.expirationTime = now + message.GetVTime ();
+            m_olsr->AddMprSelectorTuple (newMprSelector);
+            m_sweeper.AddMprSelector (newMprSelector.mainAddr, newMprSelector.expirationTime);
+         }
+      }
+   }
+}
+
+/**
+ * Same steps as RoutingProtocol::PopulateTwoHopNeighborSet, except that the
+ * expiration of a new 2-hop neighbor tuple is checked by the TupleSweeper
+ */
+void OlsrReceiver::PopulateTwoHopNeighborSet (const olsr::MessageHeader &message, const olsr::MessageHeader::Hello &hello) {
+   Time now = Simulator::Now ();
+   Ipv4Address originator = message.GetOriginatorAddress ();
+   const LinkSet &links = m_olsr->m_state.GetLinks ();
+   for (LinkSet::const_iterator link = links.begin (); link != links.end (); link++) {
+      if (m_olsr->GetMainAddress (link->neighborIfaceAddr) != originator || link->symTime < now) {
+         continue;
+      }
+      for (uint32_t i = 0; i < hello.linkMessages.size (); i++) {
+         const olsr::MessageHeader::Hello::LinkMessage &linkMessage = hello.linkMessages[i];
+         int neighborType = (linkMessage.linkCode >> 2) & 0x03;
+         for (uint32_t j = 0; j < linkMessage.neighborInterfaceAddresses.size (); j++) {
+            Ipv4Address twoHopAddress = m_olsr->GetMainAddress (linkMessage.neighborInterfaceAddresses[j]);
+            if (neighborType == OLSR_SYM_NEIGH || neighborType == OLSR_MPR_NEIGH) {
+               if (twoHopAddress == m_olsr->m_mainAddress) {
+                  continue;                                             //El nodo no es su propio vecino a 2 saltos
+               }
+               olsr::TwoHopNeighborTuple *twoHop = m_olsr->m_state.FindTwoHopNeighborTuple (originator, twoHopAddress);
+               if (twoHop != NULL) {
+                  twoHop->expirationTime = now + message.GetVTime ();
+               }
+               else {
+                  olsr::TwoHopNeighborTuple newTwoHop;
+                  newTwoHop.neighborMainAddr = originator;
+                  newTwoHop.twoHopNeighborAddr = twoHopAddress;
+                  newTwoHop.expirationTime = now + message.GetVTime ();
+                  m_olsr->AddTwoHopNeighborTuple (newTwoHop);
+                  m_sweeper.AddTwoHop (newTwoHop.neighborMainAddr, newTwoHop.twoHopNeighborAddr, newTwoHop.expirationTime);
+               }
+            }
+            else if (neighborType == OLSR_NOT_NEIGH) {
+               m_olsr->m_state.EraseTwoHopNeighborTuples (originator, twoHopAddress);
+            }
+         }
+      }
+   }
+}
+
+/**
+ * Same steps as RoutingProtocol::ProcessHello, with the MPR set computed by
+ * the MprCalculator
+ */
+void OlsrReceiver::ProcessHello (const olsr::MessageHeader &message, const Ipv4Address &receiverIface, const Ipv4Address &senderIface) {
+   const olsr::MessageHeader::Hello &hello = message.GetHello ();
+   LinkSensing (message, hello, receiverIface, senderIface);
+   m_olsr->PopulateNeighborSet (message, hello);
+   PopulateTwoHopNeighborSet (message, hello);
+   m_mprCalculator.Compute (m_olsr);
+   PopulateMprSelectorSet (message, hello);
+}
+
+/**
+ * Same as RoutingProtocol::ProcessHna, except that the expiration of a new
+ * association tuple is checked by the TupleSweeper
+ */
+void OlsrReceiver::ProcessHna (const olsr::MessageHeader &message, const Ipv4Address &senderIface) {
+   const olsr::MessageHeader::Hna &hna = message.GetHna ();
+   Time now = Simulator::Now ();
+   if (m_olsr->m_state.FindSymLinkTuple (senderIface, now) == NULL) {
+      return;                                                           //El emisor no es un vecino simetrico
+   }
+   for (uint32_t i = 0; i < hna.associations.size (); i++) {
+      olsr::AssociationTuple *association = m_olsr->m_state.FindAssociationTuple (message.GetOriginatorAddress (), hna.associations[i].address, hna.associations[i].mask);
+      if (association != NULL) {
+         association->expirationTime = now + message.GetVTime ();
+      }
+      else {
+         olsr::AssociationTuple newAssociation = { message.GetOriginatorAddress (), hna.associations[i].address, hna.associations[i].mask, now + message.GetVTime () };
+         m_olsr->AddAssociationTuple (newAssociation);
+         m_sweeper.AddAssociation (newAssociation.gatewayAddr, newAssociation.networkAddr, newAssociation.netmask, newAssociation.expirationTime);
+      }
+   }
+}
+
+/**
+ * Same as RoutingProtocol::RecvOlsr, with the HELLO messages processed by
+ * ProcessHello. The messages of unknown type keep their place among the
+ * others through v_offsets
+ */
+void OlsrReceiver::ProcessMessages (uint32_t length, const Ipv4Address &receiverIface, const Ipv4Address &senderIface) {
+   uint32_t count = 0;                                                  //Mensajes decodificados
+   uint32_t offset = PACKET_HEADER_BYTES;
+   v_offsets.clear ();
+   while (offset + MESSAGE_HEADER_BYTES <= length) {
+      const uint8_t *data = &v_buffer[offset];
+      uint16_t messageSize = ReadU16 (data + 2);
+      if (messageSize < MESSAGE_HEADER_BYTES || messageSize > length - offset) {
+         break;                                                         //Mensaje malformado
+      }
+      m_messages += 1;
+      if (!IsKnown (data[0])) {
+         v_offsets.push_back (offset);                                  //Solo se reenvia, sin decodificarlo
+      }
+      else {
+         if (count == v_messages.size ()) {
+            ResizeMessages (count + 1);
+         }
+         if (Decode (data, messageSize, v_messages[count])) {
+            v_offsets.push_back (offset);
+            count += 1;
+         }
+      }
+      offset += messageSize;
+   }
+   ResizeMessages (count);
+   m_decodedMessages += count;
+   if (m_tracePackets) {
+      m_olsr->m_rxPacketTrace (m_packetHeader, v_messages);
+   }
+   
+   uint32_t next = 0;                                                   //Siguiente mensaje de v_messages
+   for (uint32_t i = 0; i < v_offsets.size (); i++) {
+      uint8_t *data = &v_buffer[v_offsets[i]];
+      if (!IsKnown (data[0])) {
+         ProcessUnknown (data, ReadU16 (data + 2), receiverIface, senderIface);
+         continue;
+      }
+      olsr::MessageHeader &message = v_messages[next++];
+      if (message.GetTimeToLive () == 0 || message.GetOriginatorAddress () == m_olsr->m_mainAddress) {
+         continue;
+      }
+      
+      bool forward = true;
+      olsr::DuplicateTuple *duplicated = m_tupleIndex.FindDuplicateTuple (message.GetOriginatorAddress (), message.GetMessageSequenceNumber ());
+      if (duplicated == NULL) {
+         switch (message.GetMessageType ()) {
+            case olsr::MessageHeader::HELLO_MESSAGE:
+               ProcessHello (message, receiverIface, senderIface);
+               break;
+            case olsr::MessageHeader::TC_MESSAGE:
+               ProcessTc (message, senderIface);
+               break;
+            case olsr::MessageHeader::MID_MESSAGE:
+               ProcessMid (message, senderIface);
+               break;
+            case olsr::MessageHeader::HNA_MESSAGE:
+               ProcessHna (message, senderIface);
+               break;
+         }
+      }
+      else {
+         forward = std::find (duplicated->ifaceList.begin (), duplicated->ifaceList.end (), receiverIface) == duplicated->ifaceList.end ();   //No fue considerado para reenvio por esta interfaz
+      }
+      if (forward && message.GetMessageType () != olsr::MessageHeader::HELLO_MESSAGE) {
+         if (Forward (message.GetOriginatorAddress (), message.GetMessageSequenceNumber (), message.GetTimeToLive (), duplicated, receiverIface, senderIface)) {
+            Retransmit (message);
+         }
+      }
+   }
+}
+
+/**
+ * Follows RoutingProtocol::RecvOlsr, message by message. The skipped
+ * messages are not read beyond their fixed header
+ */
+void OlsrReceiver::ProcessMessagesLazily (uint32_t length, const Ipv4Address &receiverIface, const Ipv4Address &senderIface) {
+   uint32_t offset = PACKET_HEADER_BYTES;
+   while (offset + MESSAGE_HEADER_BYTES <= length) {
+      
+      /* Solo se lee la cabecera fija del mensaje */
+      uint8_t *data = &v_buffer[offset];
+      uint8_t type = data[0];
+      uint16_t messageSize = ReadU16 (data + 2);
+      Ipv4Address originator = Ipv4Address::Deserialize (data + 4);
+      uint8_t ttl = data[8];
+      uint16_t sequenceNumber = ReadU16 (data + 10);
+      if (messageSize < MESSAGE_HEADER_BYTES || messageSize > length - offset) {
+         break;                                                         //Mensaje malformado
+      }
+      offset += messageSize;
+      m_messages += 1;
+      
+      if (!IsKnown (type)) {
+         ProcessUnknown (data, messageSize, receiverIface, senderIface);
+         continue;
+      }
+      if (ttl == 0 || originator == m_olsr->m_mainAddress) {
+         continue;                                                      //Se descarta sin decodificarlo
+      }
+      
+      olsr::DuplicateTuple *duplicated = m_tupleIndex.FindDuplicateTuple (originator, sequenceNumber);
+      if (duplicated == NULL) {
+         
+         /* El mensaje es nuevo: se decodifica y se procesa como en RecvOlsr */
+         if (!Decode (data, messageSize, m_message)) {
+            continue;
+         }
+         m_decodedMessages += 1;
+         switch (type) {
+            case olsr::MessageHeader::HELLO_MESSAGE:
+               ProcessHello (m_message, receiverIface, senderIface);
+               break;
+            case olsr::MessageHeader::TC_MESSAGE:
+               ProcessTc (m_message, senderIface);
+               break;
+            case olsr::MessageHeader::MID_MESSAGE:
+               ProcessMid (m_message, senderIface);
+               break;
+            case olsr::MessageHeader::HNA_MESSAGE:
+               ProcessHna (m_message, senderIface);
+               break;
+         }
+         if (type != olsr::MessageHeader::HELLO_MESSAGE && Forward (originator, sequenceNumber, ttl, NULL, receiverIface, senderIface)) {
+            Retransmit (m_message);
+         }
+         continue;
+      }
+      
+      /* El mensaje esta duplicado: no se procesa, solo se decodifica si se retransmite */
+      bool considered = std::find (duplicated->ifaceList.begin (), duplicated->ifaceList.end (), receiverIface) != duplicated->ifaceList.end ();
+      if (type == olsr::MessageHeader::HELLO_MESSAGE || considered) {
+         continue;                                                      //Ya fue considerado para reenvio por esta interfaz
+      }
+      if (Forward (originator, sequenceNumber, ttl, duplicated, receiverIface, senderIface) && Decode (data, messageSize, m_message)) {
+         m_decodedMessages += 1;
+         Retransmit (m_message);
+      }
+   }
+}
+
+/**
+ * Same as RoutingProtocol::ProcessMid, except that the expiration of a new
+ * interface association tuple is checked by the TupleSweeper
+ */
+void OlsrReceiver::ProcessMid (const olsr::MessageHeader &message, const Ipv4Address &senderIface) {
+   const olsr::MessageHeader::Mid &mid = message.GetMid ();
+   Time now = Simulator::Now ();
+   OlsrState &state = m_olsr->m_state;
+   if (state.FindSymLinkTuple (senderIface, now) == NULL) {
+      return;                                                           //El emisor no es un vecino simetrico
+   }
+   for (uint32_t i = 0; i < mid.interfaceAddresses.size (); i++) {
+      bool updated = false;
+      IfaceAssocSet &ifaceAssocs = state.GetIfaceAssocSetMutable ();
+      for (IfaceAssocSet::iterator it = ifaceAssocs.begin (); it != ifaceAssocs.end (); it++) {
+         if (it->ifaceAddr == mid.interfaceAddresses[i] && it->mainAddr == message.GetOriginatorAddress ()) {
+            it->time = now + message.GetVTime ();
+            updated = true;
+         }
+      }
+      if (!updated) {
+         olsr::IfaceAssocTuple newIfaceAssoc;
+         newIfaceAssoc.ifaceAddr = mid.interfaceAddresses[i];
+         newIfaceAssoc.mainAddr = message.GetOriginatorAddress ();
+         newIfaceAssoc.time = now + message.GetVTime ();
+         m_olsr->AddIfaceAssocTuple (newIfaceAssoc);
+         m_sweeper.AddIfaceAssoc (newIfaceAssoc.ifaceAddr, newIfaceAssoc.time);
+      }
+   }
+   
+   /* Las direcciones de los vecinos se actualizan con la nueva informacion MID */
+   NeighborSet &neighbors = state.GetNeighbors ();
+   for (NeighborSet::iterator it = neighbors.begin (); it != neighbors.end (); it++) {
+      it->neighborMainAddr = m_olsr->GetMainAddress (it->neighborMainAddr);
+   }
+   TwoHopNeighborSet &twoHopNeighbors = state.GetTwoHopNeighbors ();
+   for (TwoHopNeighborSet::iterator it = twoHopNeighbors.begin (); it != twoHopNeighbors.end (); it++) {
+      it->neighborMainAddr = m_olsr->GetMainAddress (it->neighborMainAddr);
+      it->twoHopNeighborAddr = m_olsr->GetMainAddress (it->twoHopNeighborAddr);
+   }
+}
+
+/**
+ * Same as RoutingProtocol::ProcessTc, except that the topology set is
+ * looked up through the OlsrTupleIndex and the expiration of a new
+ * topology tuple is checked by the TupleSweeper
+ */
+void OlsrReceiver::ProcessTc (const olsr::MessageHeader &message, const Ipv4Address &senderIface) {
+   const olsr::MessageHeader::Tc &tc = message.GetTc ();
+   Time now = Simulator::Now ();
+   OlsrState &state = m_olsr->m_state;
+   Ipv4Address originator = message.GetOriginatorAddress ();
+   
+   if (state.FindSymLinkTuple (senderIface, now) == NULL) {
+      return;                                                           //El emisor no es un vecino simetrico
+   }
+   if (m_tupleIndex.FindNewerTopologyTuple (originator, tc.ansn) != NULL) {
+      return;                                                           //Ya se recibio un TC mas reciente del originador
+   }
+   m_tupleIndex.EraseOlderTopologyTuples (originator, tc.ansn);
+   
+   for (uint32_t i = 0; i < tc.neighborAddresses.size (); i++) {
+      olsr::TopologyTuple *topologyTuple = m_tupleIndex.FindTopologyTuple (tc.neighborAddresses[i], originator);
+      if (topologyTuple != NULL) {
+         topologyTuple->expirationTime = now + message.GetVTime ();
+      }
+      else {
+         olsr::TopologyTuple newTopology;
+         newTopology.destAddr = tc.neighborAddresses[i];
+         newTopology.lastAddr = originator;
+         newTopology.sequenceNumber = tc.ansn;
+         newTopology.expirationTime = now + message.GetVTime ();
+         m_tupleIndex.AddTopologyTuple (newTopology);
+         m_sweeper.AddTopology (newTopology.destAddr, newTopology.lastAddr, newTopology.expirationTime);
+      }
+   }
+}
+
+/**
+ * Same steps as RoutingProtocol::RecvOlsr with a message it does not process
+ */
+void OlsrReceiver::ProcessUnknown (uint8_t *data, uint32_t size, const Ipv4Address &receiverIface, const Ipv4Address &senderIface) {
+   Ipv4Address originator = Ipv4Address::Deserialize (data + 4);
+   uint8_t ttl = data[8];
+   uint16_t sequenceNumber = ReadU16 (data + 10);
+   if (ttl == 0 || originator == m_olsr->m_mainAddress) {
+      return;
+   }
+   olsr::DuplicateTuple *duplicated = m_tupleIndex.FindDuplicateTuple (originator, sequenceNumber);
+   if (duplicated != NULL && std::find (duplicated->ifaceList.begin (), duplicated->ifaceList.end (), receiverIface) != duplicated->ifaceList.end ()) {
+      return;                                                           //Ya fue considerado para reenvio por esta interfaz
+   }
+   if (Forward (originator, sequenceNumber, ttl, duplicated, receiverIface, senderIface)) {
+      RetransmitUnknown (data, size);
+   }
+}
+
+/**
+ * The addresses are written over the previous ones, without giving back
+ * the memory of the vector
+ */
+void OlsrReceiver::ReadAddresses (const uint8_t *data, uint32_t count, std::vector<Ipv4Address> &addresses) {
+   addresses.resize (count);
+   for (uint32_t i = 0; i < count; i++) {
+      addresses[i] = Ipv4Address::Deserialize (data + 4 * i);
+   }
+}
+
+/**
+ *
+ */
+uint16_t OlsrReceiver::ReadU16 (const uint8_t *data) {
+   return (data[0] << 8) | data[1];
+}
+
+/**
+ *
+ */
+uint32_t OlsrReceiver::ReadU32 (const uint8_t *data) {
+   return ((uint32_t) data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+/**
+ * The packet is copied once to the buffer of the receiver, and its
+ * messages are read from there
+ */
+void OlsrReceiver::Receive (Ptr<Socket> socket) {
+   Address sourceAddress;
+   Ptr<Packet> packet = socket->RecvFrom (sourceAddress);
+   Ipv4Address senderIface = InetSocketAddress::ConvertFrom (sourceAddress).GetIpv4 ();      //Interfaz del vecino que envio el paquete
+   std::map<Ptr<Socket>, Ipv4InterfaceAddress>::const_iterator local = m_olsr->m_socketAddresses.find (socket);
+   if (local == m_olsr->m_socketAddresses.end ()) {
+      return;                                                           //El socket ya no es del protocolo
+   }
+   Ipv4Address receiverIface = local->second.GetLocal ();                                  //Interfaz del nodo que lo recibio
+   
+   uint32_t size = packet->GetSize ();
+   if (size < PACKET_HEADER_BYTES) {
+      return;                                                           //Paquete malformado
+   }
+   if (v_buffer.size () < size) {
+      v_buffer.resize (size);
+   }
+   packet->CopyData (&v_buffer[0], size);
+   m_packetHeader.SetPacketLength (ReadU16 (&v_buffer[0]));
+   m_packetHeader.SetPacketSequenceNumber (ReadU16 (&v_buffer[2]));
+   uint32_t length = std::min<uint32_t> (m_packetHeader.GetPacketLength (), size);     //Longitud indicada por la cabecera del paquete
+   
+   if (m_lazyDecoding && !m_tracePackets) {
+      ProcessMessagesLazily (length, receiverIface, senderIface);
+   }
+   else {
+      ProcessMessages (length, receiverIface, senderIface);
+   }
+   
+   m_olsr->RoutingTableComputation ();         //Como en RecvOlsr, despues de procesar todos los mensajes
+}
+
+/**
+ * The address vectors of the link messages removed are kept apart and given
+ * to the link messages added later
+ */
+void OlsrReceiver::ResizeLinkMessages (std::vector<olsr::MessageHeader::Hello::LinkMessage> &linkMessages, uint32_t size) {
+   while (linkMessages.size () > size) {
+      v_spareAddresses.push_back (std::vector<Ipv4Address> ());
+      v_spareAddresses.back ().swap (linkMessages.back ().neighborInterfaceAddresses);
+      linkMessages.pop_back ();
+   }
+   while (linkMessages.size () < size) {
+      linkMessages.push_back (olsr::MessageHeader::Hello::LinkMessage ());
+      if (!v_spareAddresses.empty ()) {
+         linkMessages.back ().neighborInterfaceAddresses.swap (v_spareAddresses.back ());
+         v_spareAddresses.pop_back ();
+      }
+   }
+}
+
+/**
+ * Same as ResizeLinkMessages, with the bodies of the messages
+ */
+void OlsrReceiver::ResizeMessages (uint32_t size) {
+   while (v_messages.size () > size) {
+      v_spareMessages.push_back (olsr::MessageHeader ());
+      SwapBodies (v_spareMessages.back (), v_messages.back ());
+      v_messages.pop_back ();
+   }
+   while (v_messages.size () < size) {
+      v_messages.push_back (olsr::MessageHeader ());
+      if (!v_spareMessages.empty ()) {
+         SwapBodies (v_messages.back (), v_spareMessages.back ());
+         v_spareMessages.pop_back ();
+      }
+   }
+}
+
+/**
+ * The message is queued as in RoutingProtocol::ForwardDefault, without the
+ * copy made there to change its TTL and hop count. QueueMessage still keeps
+ * its own copy until the queued messages are sent
+ */
+void OlsrReceiver::Retransmit (olsr::MessageHeader &message) {
+   message.SetTimeToLive (message.GetTimeToLive () - 1);
+   message.SetHopCount (message.GetHopCount () + 1);
+   m_olsr->QueueMessage (message, GetJitter ());
+}
+
+/**
+ * The message cannot be serialized by a MessageHeader, so it is not queued
+ * with the other messages: its bytes are sent in a packet of its own, after
+ * the same jitter. The TTL and hop count are changed in the buffer
+ */
+void OlsrReceiver::RetransmitUnknown (uint8_t *data, uint32_t size) {
+   data[8] -= 1;                                                        //TTL
+   data[9] += 1;                                                        //Cantidad de saltos
+   Simulator::Schedule (GetJitter (), &olsr::RoutingProtocol::SendPacket, m_olsr, Create<Packet> (data, size), olsr::MessageList ());
+}
+
+/**
+ * The bodies are reached through the accessors of each type, so the types
+ * of the messages are changed; Decode sets them again
+ */
+void OlsrReceiver::SwapBodies (olsr::MessageHeader &first, olsr::MessageHeader &second) {
+   first.SetMessageType (olsr::MessageHeader::HELLO_MESSAGE);
+   second.SetMessageType (olsr::MessageHeader::HELLO_MESSAGE);
+   first.GetHello ().linkMessages.swap (second.GetHello ().linkMessages);
+   first.SetMessageType (olsr::MessageHeader::TC_MESSAGE);
+   second.SetMessageType (olsr::MessageHeader::TC_MESSAGE);
+   first.GetTc ().neighborAddresses.swap (second.GetTc ().neighborAddresses);
+   first.SetMessageType (olsr::MessageHeader::MID_MESSAGE);
+   second.SetMessageType (olsr::MessageHeader::MID_MESSAGE);
+   first.GetMid ().interfaceAddresses.swap (second.GetMid ().interfaceAddresses);
+   first.SetMessageType (olsr::MessageHeader::HNA_MESSAGE);
+   second.SetMessageType (olsr::MessageHeader::HNA_MESSAGE);
+   first.GetHna ().associations.swap (second.GetHna ().associations);
+}
+
+/**
+ *
+ */
+void OlsrReceiver::TracePackets (bool enable) {
+   m_tracePackets = enable;
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase TupleSweeper                                                      |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+TupleSweeper::TupleSweeper (void) : m_index (NULL), m_order (0), m_doneChecks (0), m_sweeps (0) {
+}
+
+/**
+ *
+ */
+void TupleSweeper::Add (TupleExpiry &expiry) {
+   expiry.e_order = m_order++;
+   m_checks.push (expiry);
+   if (!m_event.IsRunning () || expiry.e_time < m_eventTime) {
+      m_event.Cancel ();
+      m_eventTime = expiry.e_time;
+      m_event = Simulator::Schedule (m_eventTime - Simulator::Now (), &TupleSweeper::Sweep, this);
+   }
+}
+
+/**
+ *
+ */
+void TupleSweeper::AddAssociation (Ipv4Address gatewayAddr, Ipv4Address networkAddr, Ipv4Mask netmask, Time expirationTime) {
+   TupleExpiry expiry;
+   expiry.e_time = GetCheckTime (expirationTime);
+   expiry.e_kind = TUPLE_ASSOCIATION;
+   expiry.e_address = gatewayAddr;
+   expiry.e_secondAddress = networkAddr;
+   expiry.e_mask = netmask;
+   expiry.e_sequenceNumber = 0;
+   Add (expiry);
+}
+
+/**
+ *
+ */
+void TupleSweeper::AddDuplicate (Ipv4Address address, uint16_t sequenceNumber, Time expirationTime) {
+   TupleExpiry expiry;
+   expiry.e_time = GetCheckTime (expirationTime);
+   expiry.e_kind = TUPLE_DUPLICATE;
+   expiry.e_address = address;
+   expiry.e_sequenceNumber = sequenceNumber;
+   Add (expiry);
+}
+
+/**
+ *
+ */
+void TupleSweeper::AddIfaceAssoc (Ipv4Address ifaceAddr, Time expirationTime) {
+   TupleExpiry expiry;
+   expiry.e_time = GetCheckTime (expirationTime);
+   expiry.e_kind = TUPLE_IFACE_ASSOC;
+   expiry.e_address = ifaceAddr;
+   expiry.e_sequenceNumber = 0;
+   Add (expiry);
+}
+
+/**
+ *
+ */
+void TupleSweeper::AddLink (Ipv4Address neighborIfaceAddr, Time checkTime) {
+   TupleExpiry expiry;
+   expiry.e_time = GetCheckTime (checkTime);
+   expiry.e_kind = TUPLE_LINK;
+   expiry.e_address = neighborIfaceAddr;
+   expiry.e_sequenceNumber = 0;
+   Add (expiry);
+}
+
+/**
+ *
+ */
+void TupleSweeper::AddMprSelector (Ipv4Address mainAddr, Time expirationTime) {
+   TupleExpiry expiry;
+   expiry.e_time = GetCheckTime (expirationTime);
+   expiry.e_kind = TUPLE_MPR_SELECTOR;
+   expiry.e_address = mainAddr;
+   expiry.e_sequenceNumber = 0;
+   Add (expiry);
+}
+
+/**
+ *
+ */
+void TupleSweeper::AddTopology (Ipv4Address destAddr, Ipv4Address lastAddr, Time expirationTime) {
+   TupleExpiry expiry;
+   expiry.e_time = GetCheckTime (expirationTime);
+   expiry.e_kind = TUPLE_TOPOLOGY;
+   expiry.e_address = destAddr;
+   expiry.e_secondAddress = lastAddr;
+   expiry.e_sequenceNumber = 0;
+   Add (expiry);
+}
+
+/**
+ *
+ */
+void TupleSweeper::AddTwoHop (Ipv4Address neighborMainAddr, Ipv4Address twoHopNeighborAddr, Time expirationTime) {
+   TupleExpiry expiry;
+   expiry.e_time = GetCheckTime (expirationTime);
+   expiry.e_kind = TUPLE_TWO_HOP;
+   expiry.e_address = neighborMainAddr;
+   expiry.e_secondAddress = twoHopNeighborAddr;
+   expiry.e_sequenceNumber = 0;
+   Add (expiry);
+}
+
+/**
+ * Same checks as DupTupleTimerExpire, LinkTupleTimerExpire,
+ * Nb2hopTupleTimerExpire, MprSelTupleTimerExpire, TopologyTupleTimerExpire,
+ * IfaceAssocTupleTimerExpire and AssociationTupleTimerExpire
+ */
+bool TupleSweeper::Check (TupleExpiry &expiry) {
+   Time now = Simulator::Now ();
+   OlsrState &state = m_olsr->m_state;
+   switch (expiry.e_kind) {
+      case TUPLE_DUPLICATE: {
+         olsr::DuplicateTuple *tuple = m_index->FindDuplicateTuple (expiry.e_address, expiry.e_sequenceNumber);
+         if (tuple == NULL) {
+            return false;                               //La tupla ya fue eliminada
+         }
+         if (tuple->expirationTime < now) {
+            m_index->RemoveDuplicateTuple (*tuple);
+            return false;
+         }
+         expiry.e_time = GetCheckTime (tuple->expirationTime);   //La tupla fue renovada
+         return true;
+      }
+      case TUPLE_LINK: {
+         olsr::LinkTuple *tuple = state.FindLinkTuple (expiry.e_address);
+         if (tuple == NULL) {
+            return false;
+         }
+         if (tuple->time < now) {
+            m_olsr->RemoveLinkTuple (*tuple);
+            return false;
+         }
+         if (tuple->symTime < now) {
+            if (m_olsr->m_linkTupleTimerFirstTime) {
+               m_olsr->m_linkTupleTimerFirstTime = false;
+            }
+            else {
+               m_neighborLoss (*tuple);
+            }
+            expiry.e_time = GetCheckTime (tuple->time);
+            return true;
+         }
+         expiry.e_time = GetCheckTime (std::min (tuple->time, tuple->symTime));
+         return true;
+      }
+      case TUPLE_TWO_HOP: {
+         olsr::TwoHopNeighborTuple *tuple = state.FindTwoHopNeighborTuple (expiry.e_address, expiry.e_secondAddress);
+         if (tuple == NULL) {
+            return false;
+         }
+         if (tuple->expirationTime < now) {
+            m_olsr->RemoveTwoHopNeighborTuple (*tuple);
+            return false;
+         }
+         expiry.e_time = GetCheckTime (tuple->expirationTime);
+         return true;
+      }
+      case TUPLE_MPR_SELECTOR: {
+         olsr::MprSelectorTuple *tuple = state.FindMprSelectorTuple (expiry.e_address);
+         if (tuple == NULL) {
+            return false;
+         }
+         if (tuple->expirationTime < now) {
+            m_olsr->RemoveMprSelectorTuple (*tuple);
+            return false;
+         }
+         expiry.e_time = GetCheckTime (tuple->expirationTime);
+         return true;
+      }
+      case TUPLE_TOPOLOGY: {
+         olsr::TopologyTuple *tuple = m_index->FindTopologyTuple (expiry.e_address, expiry.e_secondAddress);
+         if (tuple == NULL) {
+            return false;
+         }
+         if (tuple->expirationTime < now) {
+            m_index->RemoveTopologyTuple (*tuple);
+            return false;
+         }
+         expiry.e_time = GetCheckTime (tuple->expirationTime);
+         return true;
+      }
+      case TUPLE_IFACE_ASSOC: {
+         olsr::IfaceAssocTuple *tuple = state.FindIfaceAssocTuple (expiry.e_address);
+         if (tuple == NULL) {
+            return false;
+         }
+         if (tuple->time < now) {
+            m_olsr->RemoveIfaceAssocTuple (*tuple);
+            return false;
+         }
+         expiry.e_time = GetCheckTime (tuple->time);
+         return true;
+      }
+      case TUPLE_ASSOCIATION: {
+         olsr::AssociationTuple *tuple = state.FindAssociationTuple (expiry.e_address, expiry.e_secondAddress, expiry.e_mask);
+         if (tuple == NULL) {
+            return false;
+         }
+         if (tuple->expirationTime < now) {
+            m_olsr->RemoveAssociationTuple (*tuple);
+            return false;
+         }
+         expiry.e_time = GetCheckTime (tuple->expirationTime);
+         return true;
+      }
+   }
+   return false;
+}
+
+/**
+ *
+ */
+uint64_t TupleSweeper::GetChecks (void) const {
+   return m_doneChecks;
+}
+
+/**
+ *
+ */
+Time TupleSweeper::GetCheckTime (Time expirationTime) {
+   Time now = Simulator::Now ();
+   return ((expirationTime < now) ? now : expirationTime) + Seconds (0.000001);
+}
+
+/**
+ *
+ */
+uint64_t TupleSweeper::GetSweeps (void) const {
+   return m_sweeps;
+}
+
+/**
+ *
+ */
+void TupleSweeper::Install (Ptr<olsr::RoutingProtocol> olsr, OlsrTupleIndex *index, Callback<void, const olsr::LinkTuple &> neighborLoss) {
+   m_olsr = olsr;
+   m_index = index;
+   m_neighborLoss = neighborLoss;
+}
+
+/**
+ * A check that is done again is added with a new order, as the protocol
+ * schedules a new event for it
+ */
+void TupleSweeper::Sweep (void) {
+   Time now = Simulator::Now ();
+   m_sweeps += 1;
+   while (!m_checks.empty () && m_checks.top ().e_time <= now) {
+      TupleExpiry expiry = m_checks.top ();
+      m_checks.pop ();
+      m_doneChecks += 1;
+      if (Check (expiry)) {
+         expiry.e_order = m_order++;
+         m_checks.push (expiry);
+      }
+   }
+   if (!m_checks.empty ()) {
+      m_eventTime = m_checks.top ().e_time;
+      m_event = Simulator::Schedule (m_eventTime - now, &TupleSweeper::Sweep, this);
+   }
+}
+
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase Noria                                                             |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+Noria::Noria () : n_denseForwarding (false), n_lazyOlsrDecoding (false), n_receiveOlsr (false), n_traceOlsr (true), n_reserved (false), n_reservedTime (0), n_computed (false), n_routesPatched (false), n_tableOverwritten (false), n_reservedFingerprint (0), n_recalculations (0), n_skippedRecalculations (0), n_reusedRecalculations (0), n_lastRecalculation (-std::numeric_limits<double>::infinity ()), n_recalculationPending (false) {
+}
+
+/**
+ * Step 5 of the routing table calculation: the HNA routing table is rebuilt
+ * from the association set and the current routing table
+ */
+void Noria::AddAssociationRoutes (void) {
+   // 5. For each tuple in the association set,
+   //    If there is no entry in the routing table with:
+   //        R_dest_addr     == A_network_addr/A_netmask
+   //   and if the announced network is not announced by the node itself,
+   //   then a new routing entry is created.
+   const AssociationSet &associationSet = n_olsr->m_state.GetAssociationSet ();
+   
+   // Clear HNA routing table
+   while (n_routes.GetNHnaRoutes () > 0) {
+      n_routes.RemoveHnaRoute (0);
+   }
+   
+   for (AssociationSet::const_iterator it = associationSet.begin (); it != associationSet.end (); it++) {
+      AssociationTuple const &tuple = *it;
+      
+      // Test if HNA associations received from other gateways
+      // are also announced by this node. In such a case, no route
+      // is created for this association tuple (go to the next one).
+      bool goToNextAssociationTuple = false;
+      const Associations &localHnaAssociations = n_olsr->m_state.GetAssociations ();
+      NS_LOG_DEBUG ("Nb local associations: " << localHnaAssociations.size ());
+      for (Associations::const_iterator assocIterator = localHnaAssociations.begin (); assocIterator != localHnaAssociations.end (); assocIterator++) {
+         Association const &localHnaAssoc = *assocIterator;
+         if (localHnaAssoc.networkAddr == tuple.networkAddr && localHnaAssoc.netmask == tuple.netmask) {
+            NS_LOG_DEBUG ("HNA association received from another GW is part of local HNA associations: no route added for network "
+                            << tuple.networkAddr << "/" << tuple.netmask);
+            goToNextAssociationTuple = true;
+         }
+      }
+      if (goToNextAssociationTuple) {
+         continue;
+      }
+      
+      RoutingTableEntry gatewayEntry;
+      bool gatewayEntryExists = n_routes.Lookup (tuple.gatewayAddr, gatewayEntry);
+      bool addRoute = false;
+      uint32_t routeIndex = n_routes.FindHnaRoute (tuple.networkAddr, tuple.netmask);
+      
+      if (routeIndex == n_routes.GetNHnaRoutes ()) {
+         addRoute = true;
+      }
+      else if (gatewayEntryExists && n_routes.GetHnaMetric (routeIndex) > gatewayEntry.distance) {
+         n_routes.RemoveHnaRoute (routeIndex);
+         addRoute = true;
+      }
+      
+      if(addRoute && gatewayEntryExists) {
+         n_routes.AddHnaRoute (tuple.networkAddr, tuple.netmask, gatewayEntry.nextAddr, gatewayEntry.interface, gatewayEntry.distance);
+      }
+   }
+}
+
+/**
+ * Step 4 of the routing table calculation: routes to the interface
+ * addresses of the destinations that are not routed yet
+ */
+void Noria::AddIfaceAssocRoutes (void) {
+   // 4. For each entry in the multiple interface association base
+   // where there exists a routing entry such that:
+   // R_dest_addr == I_main_addr (of the multiple interface association entry)
+   // AND there is no routing entry such that:
+   // R_dest_addr == I_iface_addr
+   const IfaceAssocSet &ifaceAssocSet = n_olsr->m_state.GetIfaceAssocSet ();
+   for (IfaceAssocSet::const_iterator it = ifaceAssocSet.begin (); it != ifaceAssocSet.end (); it++) {
+      IfaceAssocTuple const &tuple = *it;
+      RoutingTableEntry entry1, entry2;
+      bool have_entry1 = n_routes.Lookup (tuple.mainAddr, entry1);
+      bool have_entry2 = n_routes.Lookup (tuple.ifaceAddr, entry2);
+      if (have_entry1 && !have_entry2 && !n_reservednodes.Exist(entry1.nextAddr)) {     // MODIFICADO
+         // then a route entry is created in the routing table with:
+         //       R_dest_addr  =  I_iface_addr (of the multiple interface
+         //                                     association entry)
+         //       R_next_addr  =  R_next_addr  (of the recorded route entry)
+         //       R_dist       =  R_dist       (of the recorded route entry)
+         //       R_iface_addr =  R_iface_addr (of the recorded route entry).
+         SetRoute (tuple.ifaceAddr, entry1.nextAddr, entry1.interface, entry1.distance);
+      }
+   }
+}
+
+/**
+ *
+ */
+void Noria::AddRelation (Mac48Address mac, Ipv4Address ip) {
+   n_relations.Add (mac, ip);
+}
+
+/**
+ *
+ */
+void Noria::AddReserved (Ipv4Address ip, double time) {
+   if (n_reservednodes.Add (ip, time)) {
+      RestrictReservedRoutes (ip);
+   }
+}
+
+/**
+ *
+ */
+void Noria::AddTransmission (Ipv4Address ip, double time) {
+   n_transmissions.Add (ip, time);
+}
+
+/**
+ * Only the routes that changed are written to the OLSR routing table, and
+ * the change is notified only if there was any
+ */
+void Noria::ApplyRoutes (void) {
+   if (n_routes.Apply (n_olsr)) {
+      n_olsr->m_routingTableChanged (n_olsr->GetSize ());
+   }
+   n_tableOverwritten = false;          //Despues de la notificacion, que tambien llega a NotifyRoutingTableChanged
+}
+
+/**
+ * The routing table can be patched when it is the one computed by the Noria
+ * for the current OLSR state
+ */
+bool Noria::CanPatchRoutes (void) {
+   return !n_tableOverwritten && !n_recalculationPending && GetStateSnapshot (Simulator::Now ()) == n_stateSnapshot;
+}
+
+/**
+ * Computes the routing table according to the implementations of the OLSR's routing table calculation algorithm
+ * found in src/olsr/model/olsr-routing-protocol.cc
+ * Every timen when a new entre is going to be added in the routing table, a new condition is evaluated. It checks if the
+ * r_next_addr is not in the list of the reserved nodes identified by the Noria. If the IP address is not registered as
+ * reserved then the r_next_addr is added in the routing table as a next address, if not the entry is not added.
+ */
+bool Noria::ComputeRoutingTable (Time now) {
+   StateSnapshot snapshot = GetStateSnapshot (now);
+   uint64_t fingerprint = n_reservednodes.GetFingerprint ();
+   std::vector<uint32_t> reserved;                                  //Nodos reservados, comparados cuando coinciden las huellas
+   n_reservednodes.GetAddresses (reserved);
+   
+   // Sin reservas la tabla calculada por OLSR es igual a la del Noria
+   bool tableValid = !n_tableOverwritten || n_reservednodes.GetSize () == 0;
+   if (n_computed && !n_routesPatched && tableValid && snapshot == n_stateSnapshot && fingerprint == n_reservedFingerprint && reserved == n_reservedAddresses) {
+      n_skippedRecalculations += 1;
+      return false;
+   }
+   n_lastRecalculation = now.GetSeconds ();
+   n_recalculationPending = false;
+   n_stateIndex.Build (n_olsr->m_state, snapshot);                  //Tambien lo usan las reparaciones mientras el estado no cambie
+   if (RestoreRoutes (snapshot, fingerprint, reserved)) {
+      n_reusedRecalculations += 1;
+      IndexNextHops ();
+      n_computed = true;
+      n_routesPatched = false;
+      n_stateSnapshot = snapshot;
+      n_reservedFingerprint = fingerprint;
+      n_reservedAddresses.swap (reserved);
+      return true;
+   }
+   n_recalculations += 1;
+   
+   NS_LOG_DEBUG (now.GetSeconds() << " s: Node " << n_olsr->m_mainAddress << ": RoutingTableComputation begin...");
+   
+   // 1. All the entries from the routing table are removed.
+   //    (La tabla se calcula aparte y al final solo se aplican a OLSR las rutas que cambiaron)
+   n_routes.Clear ();
+   
+   // 2. The new routing entries are added starting with the
+   // symmetric neighbors (h=1) as the destination nodes.
+   //
+   // La direccion principal del vecino de cada enlace valido se obtiene una
+   // sola vez y los enlaces se agrupan por ella, conservando su orden
+   const LinkSet &linkSet = n_olsr->m_state.GetLinks ();
+   n_neighborLinks.Clear ();                                                   //Posiciones de los enlaces validos de cada vecino
+   for (uint32_t i = 0; i < linkSet.size (); i++) {
+      LinkTuple const &link_tuple = linkSet[i];
+      NS_LOG_DEBUG ("Looking at link tuple: " << link_tuple << (link_tuple.time >= now ? "" : " (expired)"));
+      if (link_tuple.time >= now) {
+         n_neighborLinks.Add (n_stateIndex.GetMainAddress (link_tuple.neighborIfaceAddr), i);
+      }
+   }
+   
+   const NeighborSet &neighborSet = n_olsr->m_state.GetNeighbors ();
+   for (NeighborSet::const_iterator it = neighborSet.begin (); it != neighborSet.end (); it++) {
+      NeighborTuple const &nb_tuple = *it;
+      NS_LOG_DEBUG ("Looking at neighbor tuple: " << nb_tuple);
+      if (nb_tuple.status == NeighborTuple::STATUS_SYM) {
+         bool nb_main_addr = false;
+         const LinkTuple *lt = NULL;
+         const std::vector<uint32_t> &links = n_neighborLinks.Get (nb_tuple.neighborMainAddr);
+         for (uint32_t i = 0; i < links.size (); i++) {
+            LinkTuple const &link_tuple = linkSet[links[i]];
+            NS_LOG_LOGIC ("Link tuple matches neighbor " << nb_tuple.neighborMainAddr << " => adding routing table entry to neighbor");
+            lt = &link_tuple;
+            n_routes.AddEntry (link_tuple.neighborIfaceAddr, link_tuple.neighborIfaceAddr, n_olsr->m_ipv4->GetInterfaceForAddress (link_tuple.localIfaceAddr), 1);
+            if (link_tuple.neighborIfaceAddr == nb_tuple.neighborMainAddr) {
+               nb_main_addr = true;
+            }
+         }
+         
+         // If, in the above, no R_dest_addr is equal to the main
+         // address of the neighbor, then another new routing entry
+         // with MUST be added, with:
+         //      R_dest_addr  = main address of the neighbor;
+         //      R_next_addr  = L_neighbor_iface_addr of one of the
+         //                     associated link tuple with L_time >= current time;
+         //      R_dist       = 1;
+         //      R_iface_addr = L_local_iface_addr of the
+         //                     associated link tuple.
+         if (!nb_main_addr && lt != NULL) {
+            NS_LOG_LOGIC ("no R_dest_addr is equal to the main address of the neighbor "
+                            "=> adding additional routing entry");
+            n_routes.AddEntry (nb_tuple.neighborMainAddr, lt->neighborIfaceAddr, n_olsr->m_ipv4->GetInterfaceForAddress (lt->localIfaceAddr), 1);
+         }
+      }
+   }
+   
+   //  3. for each node in N2, i.e., a 2-hop neighbor which is not a
+   //  neighbor node or the node itself, and such that there exist at
+   //  least one entry in the 2-hop neighbor set where
+   //  N_neighbor_main_addr correspond to a neighbor node with
+   //  willingness different of WILL_NEVER,
+   const TwoHopNeighborSet &twoHopNeighbors = n_olsr->m_state.GetTwoHopNeighbors ();
+   for (TwoHopNeighborSet::const_iterator it = twoHopNeighbors.begin (); it != twoHopNeighbors.end (); it++) {
+      TwoHopNeighborTuple const &nb2hop_tuple = *it;
+      NS_LOG_LOGIC ("Looking at two-hop neighbor tuple: " << nb2hop_tuple);
+      
+      if (!IsTwoHopCandidate (nb2hop_tuple)) {
+         continue;
+      }
+      
+      // one selects one 2-hop tuple and creates one entry in the routing table with:
+      //                R_dest_addr  =  the main address of the 2-hop neighbor;
+      //                R_next_addr  = the R_next_addr of the entry in the
+      //                               routing table with:
+      //                                   R_dest_addr == N_neighbor_main_addr
+      //                                                  of the 2-hop tuple;
+      //                R_dist       = 2;
+      //                R_iface_addr = the R_iface_addr of the entry in the
+      //                               routing table with:
+      //                                   R_dest_addr == N_neighbor_main_addr
+      //                                                  of the 2-hop tuple;
+      RoutingTableEntry entry;
+      bool foundEntry = n_routes.Lookup (nb2hop_tuple.neighborMainAddr, entry);
+      if (foundEntry && !n_reservednodes.Exist(entry.nextAddr)) { // MODIFICADO
+         NS_LOG_LOGIC ("Adding routing entry for two-hop neighbor.");
+         n_routes.AddEntry (nb2hop_tuple.twoHopNeighborAddr, entry.nextAddr, entry.interface, 2);
+      }
+      else {
+         NS_LOG_LOGIC ("NOT adding routing entry for two-hop neighbor (" << nb2hop_tuple.twoHopNeighborAddr << " not found in the routing table)");
+      }
+   }
+   
+   // 3.1. For each topology entry in the topology table, if its
+   // T_dest_addr does not correspond to R_dest_addr of any
+   // route entry in the routing table AND its T_last_addr
+   // corresponds to R_dest_addr of a route entry whose R_dist
+   // is equal to h, then a new route entry MUST be recorded in
+   // the routing table (if it does not already exist)
+   //
+   // Las tuplas de topologia estan agrupadas por T_last_addr (n_stateIndex) y
+   // las rutas se expanden por niveles desde las rutas de distancia h. En cada
+   // nivel las tuplas candidatas se recorren en el orden del TopologySet,
+   // de modo que el resultado es el mismo que recorrer todo el conjunto por h
+   const TopologySet &topology = n_olsr->m_state.GetTopologySet ();
+   
+   std::vector<RoutingTableEntry> &frontier = n_frontier;                      //Rutas de distancia h
+   frontier.clear ();
+   for (uint32_t i = 0; i < n_routes.GetSize (); i++) {
+      if (n_routes.GetEntry (i).distance == 2) {
+         frontier.push_back (n_routes.GetEntry (i));
+      }
+   }
+   
+   std::vector<std::pair<uint32_t, uint32_t> > &candidates = n_candidates;     //Posicion de la tupla y ruta de su T_last_addr
+   std::vector<RoutingTableEntry> &next = n_nextFrontier;                      //Rutas de distancia h + 1
+   for (uint32_t h = 2; !frontier.empty (); h++) {
+      candidates.clear ();
+      for (uint32_t i = 0; i < frontier.size (); i++) {
+         if (n_reservednodes.Exist (frontier[i].nextAddr)) {   // MODIFICADO
+            continue;
+         }
+         const std::vector<uint32_t> &tuples = n_stateIndex.GetLastAddrTuples (frontier[i].destAddr);
+         for (uint32_t j = 0; j < tuples.size (); j++) {
+            candidates.push_back (std::make_pair (tuples[j], i));
+         }
+      }
+      std::sort (candidates.begin (), candidates.end ());
+      
+      next.clear ();
+      for (uint32_t i = 0; i < candidates.size (); i++) {
+         const TopologyTuple &topology_tuple = topology[candidates[i].first];
+         const RoutingTableEntry &lastAddrEntry = frontier[candidates[i].second];
+         NS_LOG_LOGIC ("Looking at topology tuple: " << topology_tuple);
+         
+         RoutingTableEntry destAddrEntry;
+         if (!n_routes.Lookup (topology_tuple.destAddr, destAddrEntry)) {
+            NS_LOG_LOGIC ("Adding routing table entry based on the topology tuple.");
+            // then a new route entry MUST be recorded in
+            //                the routing table (if it does not already exist) where:
+            //                     R_dest_addr  = T_dest_addr;
+            //                     R_next_addr  = R_next_addr of the recorded
+            //                                    route entry where:
+            //                                    R_dest_addr == T_last_addr
+            //                     R_dist       = h+1; and
+            //                     R_iface_addr = R_iface_addr of the recorded
+            //                                    route entry where:
+            //                                       R_dest_addr == T_last_addr.
+            n_routes.AddEntry (topology_tuple.destAddr, lastAddrEntry.nextAddr, lastAddrEntry.interface, h + 1);
+            destAddrEntry.destAddr = topology_tuple.destAddr;
+            destAddrEntry.nextAddr = lastAddrEntry.nextAddr;
+            destAddrEntry.interface = lastAddrEntry.interface;
+            destAddrEntry.distance = h + 1;
+            next.push_back (destAddrEntry);
+         }
+      }
+      frontier.swap (next);
+   }
+   
+   AddIfaceAssocRoutes ();
+   AddAssociationRoutes ();
+   
+   NS_LOG_DEBUG ("Node " << n_olsr->m_mainAddress << ": RoutingTableComputation end.");
+   IndexNextHops ();
+   StoreRoutes (snapshot, fingerprint, reserved);
+   n_computed = true;
+   n_routesPatched = false;
+   n_stateSnapshot = snapshot;
+   n_reservedFingerprint = fingerprint;
+   n_reservedAddresses.swap (reserved);
+   return true;
+}
+
+/**
+ *
+ */
+void Noria::DenseForwarding (bool enable) {
+   n_denseForwarding = enable;
+}
+
+/**
+ *
+ */
+void Noria::EraseReservedNode (uint32_t reservedIndex) {
+   Ipv4Address ip = n_reservednodes.GetIp (reservedIndex);
    n_reservednodes.Erase (reservedIndex);
+   ReleaseReservedRoutes (ip);
+}
+
+/**
+ *
+ */
+void Noria::EraseTransmission (Ipv4Address ip) {
+   n_transmissions.Erase (ip);
+}
+
+/**
+ *
+ */
+bool Noria::ExistTransmission (Ipv4Address ip) {
+   return n_transmissions.Exist (ip);
+}
+
+/**
+ * Each reservation resets the Noria after its lifetime, as before, but only
+ * the next reset is scheduled: the times of the others wait in order
+ */
+void Noria::ExpireReservation (void) {
+   Reset ();
+   n_resetTimes.pop_front ();
+   if (!n_resetTimes.empty ()) {
+      Simulator::Schedule (n_resetTimes.front () - Simulator::Now (), &ResetNoria, Ptr<Noria> (this));
+   }
+}
+
+/**
+ *
+ */
+void Noria::ExpireTransmissions (double time) {
+   n_transmissions.Expire (time);
+}
+
+/**
+ *
+ */
+uint32_t Noria::GetIndex () {
+   return n_index;
+}
+
+/**
+ *
+ */
+Ipv4Address Noria::GetIpAddress () {
+   Ipv4Address ip;
+   ip.Set(n_ipAddress.Get());
+   return ip;
+}
+
+/**
+ *
+ */
+double Noria::GetLastRecalculation (void) {
+   return n_lastRecalculation;
+}
+
+/**
+ *
+ */
+Mac48Address Noria::GetMacAddress () {
+   return n_macAddress;
+}
+
+/**
+ * Routes that currently go through the next hop
+ */
+void Noria::GetNextHopRoutes (Ipv4Address nextAddr, std::vector<RoutingTableEntry> &routes) {
+   std::unordered_map<uint32_t, std::vector<Ipv4Address> >::iterator it = n_nextHopRoutes.find (nextAddr.Get ());
+   if (it == n_nextHopRoutes.end ()) {
+      return;
+   }
+   std::vector<Ipv4Address> valid;
+   for (uint32_t i = 0; i < it->second.size (); i++) {
+      RoutingTableEntry entry;
+      if (n_routes.Lookup (it->second[i], entry) && entry.nextAddr == nextAddr && std::find (valid.begin (), valid.end (), entry.destAddr) == valid.end ()) {
+         routes.push_back (entry);
+         valid.push_back (entry.destAddr);
+      }
+   }
+   it->second.swap (valid);                     //Se descartan las rutas que ya no pasan por el siguiente salto
 }
 
 /**
  *
  */
-void Noria::EraseTransmission (Ipv4Address ip) {
-   n_transmissions.Erase (ip);
+const OlsrReceiver &Noria::GetOlsrReceiver (void) {
+   return n_olsrReceiver;
 }
 
 /**
  *
  */
-bool Noria::ExistTransmission (Ipv4Address ip) {
-   return n_transmissions.Exist (ip);
+uint32_t Noria::GetRecalculations (void) {
+   return n_recalculations;
 }
 
-
 /**
  *
  */
-uint32_t Noria::GetIndex () {
-   return n_index;
+double Noria::GetRecalculateRoutingTablePeriod (void) {
+   return n_recalculateRoutingTablePeriod;
 }
 
 /**
  *
  */
-Ipv4Address Noria::GetIpAddress () {
-   Ipv4Address ip;
-   ip.Set(n_ipAddress.Get());
-   return ip;
+Ipv4Address Noria::GetRelatedIpAddress (Mac48Address mac) {
+   return n_relations.GetIp (mac);
 }
 
 /**
  *
  */
-Mac48Address Noria::GetMacAddress () {
-   Mac48Address mac = Mac48Address::ConvertFrom(n_netDevice->GetAddress());
-   return mac;
+uint32_t Noria::GetReusedRecalculations (void) {
+   return n_reusedRecalculations;
 }
 
 /**
  *
  */
-double Noria::GetRecalculateRoutingTablePeriod (void) {
-   return n_recalculateRoutingTablePeriod;
+uint32_t Noria::GetSkippedRecalculations (void) {
+   return n_skippedRecalculations;
 }
 
 /**
- *
+ * The links are hashed with their validity, since the recalculation
+ * ignores the expired ones even when they are still in the set. The keys
+ * of the valid links and of the topology tuples are kept sorted, so the
+ * snapshots are compared without depending on the order of the sets
  */
-Ipv4Address Noria::GetRelatedIpAddress (Mac48Address mac) {
-   return n_relations.GetIp (mac);
+StateSnapshot Noria::GetStateSnapshot (Time now) {
+   const OlsrState &state = n_olsr->m_state;
+   StateSnapshot snapshot;
+   uint64_t hash = 0;
+   
+   const LinkSet &links = state.GetLinks ();
+   snapshot.s_counts[0] = links.size ();
+   for (LinkSet::const_iterator it = links.begin (); it != links.end (); it++) {
+      hash = Mix (hash, it->localIfaceAddr.Get ());
+      hash = Mix (hash, it->neighborIfaceAddr.Get ());
+      hash = Mix (hash, it->time >= now);
+      if (it->time >= now) {
+         snapshot.s_counts[1] += 1;
+         snapshot.s_links.push_back (((uint64_t) it->localIfaceAddr.Get () << 32) | it->neighborIfaceAddr.Get ());
+      }
+   }
+   std::sort (snapshot.s_links.begin (), snapshot.s_links.end ());
+   
+   const NeighborSet &neighbors = state.GetNeighbors ();
+   snapshot.s_counts[2] = neighbors.size ();
+   for (NeighborSet::const_iterator it = neighbors.begin (); it != neighbors.end (); it++) {
+      hash = Mix (hash, it->neighborMainAddr.Get ());
+      hash = Mix (hash, ((uint64_t) it->status << 8) | it->willingness);
+      if (it->status == NeighborTuple::STATUS_SYM) {
+         snapshot.s_counts[3] += 1;
+      }
+   }
+   
+   const TwoHopNeighborSet &twoHopNeighbors = state.GetTwoHopNeighbors ();
+   snapshot.s_counts[4] = twoHopNeighbors.size ();
+   for (TwoHopNeighborSet::const_iterator it = twoHopNeighbors.begin (); it != twoHopNeighbors.end (); it++) {
+      hash = Mix (hash, it->neighborMainAddr.Get ());
+      hash = Mix (hash, it->twoHopNeighborAddr.Get ());
+   }
+   
+   const TopologySet &topology = state.GetTopologySet ();
+   snapshot.s_counts[5] = topology.size ();
+   snapshot.s_topology.reserve (topology.size ());
+   for (TopologySet::const_iterator it = topology.begin (); it != topology.end (); it++) {
+      hash = Mix (hash, it->destAddr.Get ());
+      hash = Mix (hash, it->lastAddr.Get ());
+      snapshot.s_topology.push_back (((uint64_t) it->destAddr.Get () << 32) | it->lastAddr.Get ());
+   }
+   std::sort (snapshot.s_topology.begin (), snapshot.s_topology.end ());
+   
+   const IfaceAssocSet &ifaceAssocSet = state.GetIfaceAssocSet ();
+   snapshot.s_counts[6] = ifaceAssocSet.size ();
+   for (IfaceAssocSet::const_iterator it = ifaceAssocSet.begin (); it != ifaceAssocSet.end (); it++) {
+      hash = Mix (hash, it->ifaceAddr.Get ());
+      hash = Mix (hash, it->mainAddr.Get ());
+   }
+   
+   const AssociationSet &associationSet = state.GetAssociationSet ();
+   snapshot.s_counts[7] = associationSet.size ();
+   for (AssociationSet::const_iterator it = associationSet.begin (); it != associationSet.end (); it++) {
+      hash = Mix (hash, it->gatewayAddr.Get ());
+      hash = Mix (hash, it->networkAddr.Get ());
+      hash = Mix (hash, it->netmask.Get ());
+   }
+   
+   const Associations &associations = state.GetAssociations ();
+   snapshot.s_counts[8] = associations.size ();
+   for (Associations::const_iterator it = associations.begin (); it != associations.end (); it++) {
+      hash = Mix (hash, it->networkAddr.Get ());
+      hash = Mix (hash, it->netmask.Get ());
+   }
+   snapshot.s_hash = hash;
+   return snapshot;
 }
 
 /**
@@ -603,6 +3775,21 @@ double Noria::GetTransmissionTime (Ipv4Address ip) {
    return n_transmissions.GetTime (ip);
 }
 
+/**
+ * The reverse index is verified when it is read, since the routes of a
+ * next hop may have changed after they were indexed
+ */
+void Noria::IndexNextHops (void) {
+   std::unordered_map<uint32_t, std::vector<Ipv4Address> >::iterator it;
+   for (it = n_nextHopRoutes.begin (); it != n_nextHopRoutes.end (); it++) {
+      it->second.clear ();                     //Los vectores se conservan para reutilizar su memoria
+   }
+   for (uint32_t i = 0; i < n_routes.GetSize (); i++) {
+      const RoutingTableEntry &entry = n_routes.GetEntry (i);
+      n_nextHopRoutes[entry.nextAddr.Get ()].push_back (entry.destAddr);
+   }
+}
+
 /**
  * Basade en: src/wifi/helper/yans-wifi-helper.cc
  * Funcion: EnablePcapInternal(std::string, Ptr<NetDevice>, bool, bool)
@@ -620,26 +3807,38 @@ void Noria::Install (uint32_t index, Ipv4Address ip) {
    std::string netDevicePath = "/NodeList/" + noriaIndex.str() + "/DeviceList/0/$ns3::WifiNetDevice";   // Camino de consulta de los dispositivos de red
    match = Config::LookupMatches (netDevicePath.c_str());                                               // Buscador de correspondencias
    n_netDevice = match.Get(0)->GetObject<WifiNetDevice>();                                              // Obtencion del dispositivo de red
+   n_macAddress = Mac48Address::ConvertFrom(n_netDevice->GetAddress());                                 // Direccion MAC del dispositivo de red
    
    Ptr<WifiPhy> phy = n_netDevice->GetPhy ();                                                                   // Capa fisica del dispositivo de red
-   phy->TraceConnectWithoutContext ("MonitorSnifferRx", MakeBoundCallback (&ReceivePacket, n_netDevice));       // Establecimiento del modo promiscuo
-   phy->TraceConnectWithoutContext ("MonitorSnifferTx", MakeBoundCallback (&SendPacket, n_netDevice));
+   phy->TraceConnectWithoutContext ("MonitorSnifferRx", MakeBoundCallback (&ReceivePacket, Ptr<Noria> (this)));           // Establecimiento del modo promiscuo
+   phy->TraceConnectWithoutContext ("MonitorSnifferTx", MakeBoundCallback (&SendPacket, Ptr<Noria> (this)));
    
    n_ipAddress.Set(ip.Get());   // Indicacion de la direccion IP del nodo
    
    std::string olsrPath = "/NodeList/" + noriaIndex.str() + "/$ns3::olsr::RoutingProtocol";     // Camino de consulta al protocolo OLSR
    match = Config::LookupMatches (olsrPath.c_str());                                            // Buscador de correspondencias
    n_olsr = match.Get(0)->GetObject<olsr::RoutingProtocol>();                                   // Obtencion del protocolo OLSR
+   n_olsr->TraceConnectWithoutContext ("RoutingTableChanged", MakeBoundCallback (&RoutingTableChanged, Ptr<Noria> (this)));
+   if (n_receiveOlsr || n_lazyOlsrDecoding) {
+      n_olsrReceiver.LazyDecoding (n_lazyOlsrDecoding);                                         // Decodificacion perezosa de los mensajes OLSR
+      n_olsrReceiver.TracePackets (n_traceOlsr);                                                // Traza Rx del protocolo
+      n_olsrReceiver.Install (n_olsr);                                                          // Recepcion de los paquetes OLSR por el agente
+   }
+   if (n_denseForwarding) {
+      Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting> (n_olsr->m_ipv4->GetRoutingProtocol ());   // Lista de protocolos de enrutamiento del nodo
+      n_forwardingTable = CreateObject<ForwardingTable> ();
+      n_forwardingTable->Install (n_olsr);                                                      // Copia de la tabla de enrutamiento de OLSR
+      list->AddRoutingProtocol (n_forwardingTable, 110);                                        // Antes que OLSR, agregado con prioridad 100
+   }
    
-   n_relations.Add (Mac48Address::ConvertFrom(n_netDevice->GetAddress()), ip);
+   n_relations.Add (n_macAddress, ip);
    n_writeAddressRelations = false;
    n_writeReservationState = false;
    n_writeReservedNodes = false;
    n_writeRoutingTable = false;
    WriteConfig();
    
-   Simulator::Schedule (Seconds (Commons::RESERVED_LIFETIME), &UpdateReserved, n_index);
-   //Simulator::Schedule (Seconds (Commons::RESERVED_LIFETIME), &RecalculateTable, n_index);
+   //Simulator::Schedule (Seconds (Commons::RESERVED_LIFETIME), &RecalculateTable, Ptr<Noria> (this));
 }
 
 /**
@@ -649,360 +3848,245 @@ bool Noria::IsReserved (void) {
    return n_reserved;
 }
 
+/**
+ * Conditions of step 3 of the routing table calculation over a 2-hop tuple
+ */
+bool Noria::IsTwoHopCandidate (const TwoHopNeighborTuple &nb2hop_tuple) {
+   // a 2-hop neighbor which is not a neighbor node or the node itself
+   if (n_stateIndex.IsSymNeighbor (nb2hop_tuple.twoHopNeighborAddr)) {
+      NS_LOG_LOGIC ("Two-hop neighbor tuple is also neighbor; skipped.");
+      return false;
+   }
+   if (nb2hop_tuple.twoHopNeighborAddr == n_olsr->m_mainAddress) {
+      NS_LOG_LOGIC ("Two-hop neighbor is self; skipped.");
+      return false;
+   }
+   
+   // ...and such that there exist at least one entry in the 2-hop
+   // neighbor set where N_neighbor_main_addr correspond to a
+   // neighbor node with willingness different of WILL_NEVER...
+   if (!n_stateIndex.IsWillingNeighbor (nb2hop_tuple.neighborMainAddr)) {
+      NS_LOG_LOGIC ("Two-hop neighbor tuple skipped: 2-hop neighbor "
+                     << nb2hop_tuple.twoHopNeighborAddr
+                     << " is attached to neighbor " << nb2hop_tuple.neighborMainAddr
+                     << ", which was not found in the Neighbor Set.");
+      return false;
+   }
+   return true;
+}
+
+/**
+ *
+ */
+void Noria::LazyOlsrDecoding (bool enable) {
+   n_lazyOlsrDecoding = enable;
+}
+
+/**
+ *
+ */
+void Noria::LimitTransmissions (double lifetime, uint32_t capacity) {
+   n_transmissions.SetLifetime (lifetime);
+   n_transmissions.SetCapacity (capacity);
+}
+
+/**
+ *
+ */
+uint64_t Noria::Mix (uint64_t hash, uint64_t value) {
+   return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+/**
+ *
+ */
+void Noria::NotifyRoutingTableChanged (void) {
+   n_tableOverwritten = true;
+}
+
+/**
+ *
+ */
+void Noria::ReceiveOlsrPackets (bool enable) {
+   n_receiveOlsr = enable;
+}
+
 /**
  *
  */
-void Noria::ReceivePacketProcess (Ptr<Packet> packet) {
+void Noria::ReceivePacketProcess (const FrameInfo &frame) {
    double now = Simulator::Now().GetSeconds();        //Tiempo de simulacion (en segundos)
    
-   /* WifiMac Header */
-   WifiMacHeader macHeader;             //Formato de cabecera WifiMAC
-   packet->RemoveHeader(macHeader);     //Obtener los datos de la cabecera WifiMAC
-   if (!macHeader.IsAck()) {            //Si no es un ACK
+   Mac48Address nodeMAC = GetMacAddress();      //Direccion MAC del dispositivo de red del nodo
+   Mac48Address srcMAC = frame.f_srcMac;        //Source Address (IEEE 802.11 MAC header)
+   Mac48Address dstMAC = frame.f_dstMac;        //Destination Address (IEEE 802.11 MAC header)
+   Ipv4Address srcIP = frame.f_srcIp;           //Direccion IP origen de la transmision
+   Ipv4Address dstIP = frame.f_dstIp;           //Direccion IP destino de la transmision
    
-      /* LLC/SNAP Header */
-      LlcSnapHeader llcHeader;                  //Formato de cabecera LLC
-      if (packet->PeekHeader(llcHeader) > 0) {  //Si el paquete contiene cabecera LLC/SNAP (Formalismo, pues si lo debe tener)
-         packet->RemoveHeader(llcHeader);       //Obtener los datos de la cabecera LLS/SNAP
-      }
+   //Si el puerto UDP destino del paquete no es el mismo del protocolo OLSR
+   if (frame.f_dstPort != Commons::OLSR_PORT) { 
       
-      /* ARP Header */
-      ArpHeader arpHeader;                      //Formato de cabecera ARP
-      if (packet->PeekHeader(arpHeader) == 0) { //Si el paquete no contiene una cabecera ARP
-         
-         /* IPv4 Header */
-         Ipv4Header ipv4Header;                         //Formato de cabecera IPv4
-         if (packet->PeekHeader(ipv4Header) > 0) {      //Si el paquete contiene cabecera IPv4 (Formalismo, pues si lo debe tener)
-            packet->RemoveHeader(ipv4Header);           //Obtener los datos de la cabecera IPv4
-         }
+      /* Estos son los paquetes que se deben procesar por el Noria para identificar la reserva */
+      //Si la direccion MAC del dispositivo es igual a la direccion destino del paquete
+      if (nodeMAC == dstMAC) { 
          
-         /* UDP Header */
-         UdpHeader udpHeader;
-         if (packet->PeekHeader(udpHeader) > 0) {            //Si el paquete contiene cabecera UDP
-         
-            Mac48Address nodeMAC = GetMacAddress();          //Direccion MAC del dispositivo de red del nodo
-            Mac48Address srcMAC = macHeader.GetAddr2();      //Source Address (IEEE 802.11 MAC header)
-            Mac48Address dstMAC = macHeader.GetAddr1();      //Destination Address (IEEE 802.11 MAC header)
-            Ipv4Address srcIP = ipv4Header.GetSource();      //Direccion IP origen de la transmision
-            Ipv4Address dstIP = ipv4Header.GetDestination(); //Direccion IP destino de la transmision
+         /* El nodo recibio el paquete (es el destino a nivel de la capa de enlace) */
+         //¿El nodo no es el destino de la transmision? (Es un nodo intermedio)
+         if (srcIP != GetIpAddress()) {
             
-            //Si el puerto UDP destino del paquete no es el mismo del protocolo OLSR
-            if (udpHeader.GetDestinationPort() != Commons::OLSR_PORT) { 
+            //El nodo se encuentra reservado
+            if (IsReserved ()) {
                
-               /* Estos son los paquetes que se deben procesar por el Noria para identificar la reserva */
-               //Si la direccion MAC del dispositivo es igual a la direccion destino del paquete
-               if (nodeMAC == dstMAC) { 
-                  
-                  /* El nodo recibio el paquete (es el destino a nivel de la capa de enlace) */
-                  //¿El nodo no es el destino de la transmision? (Es un nodo intermedio)
-                  if (srcIP != GetIpAddress()) {
-                     
-                     //El nodo se encuentra reservado
-                     if (norias.IsReserved (GetIndex())) {
-                        
-                        //El nodo esta reservado
-                        if (!(srcIP == n_rSrcAddress && dstIP == n_rDstAddress)) {
-                           
-                           //Las direcciones IP origen y destino del paquete no son iguales a las direcciones de la reserva
-                           //discard(packet);
-                        }
-                     }
-                     else {
-                        
-                        //El nodo no esta reservado
-                        //El nodo no se encuentra reservado, por lo que su estado cambia a reservado
-                        norias.Reserve (GetIndex(), now, srcIP, dstIP);
-                        if (n_writeReservationState) {
-                           norias.WriteReservationState (GetIndex());
-                        }
-                     }
-                  }
-               }
-               else {
+               //El nodo esta reservado
+               if (!(srcIP == n_rSrcAddress && dstIP == n_rDstAddress)) {
                   
-                  // El nodo escucho el paquete (no es el destino a nivel de la capa de enlace)
-                  // ¿El nodo que recibio el paquete es el destino de la transmision?
-                  if (!n_relations.Related (dstMAC, dstIP)) {
-                     
-                     // ¿El destino del paquete es igual al destino de algun paquete enviado?
-                     if (!norias.ExistTransmission (GetIndex(), dstIP)) {
-                        
-                        // Reservar el nodo que recibio el paquete pues hace parte del intermedio de una transmision
-                        Ipv4Address ip = n_relations.GetIp (dstMAC);
-                        if (n_relations.Exist (ip)) {
-                           norias.AddReserved (GetIndex(), ip, now);
-                           //norias.RecalculateRoutingTable (GetIndex());
-                           if (n_writeReservedNodes) {
-                              norias.WriteReservedNodes (GetIndex());
-                           }
-                           if (n_writeRoutingTable) {
-                              norias.WriteRoutingTable (GetIndex());
-                           }
-                        }
-                     }
-                  }
+                  //Las direcciones IP origen y destino del paquete no son iguales a las direcciones de la reserva
+                  //discard(packet);
                }
             }
             else {
                
-               /* Se añade la informacion de las direcciones relacionadas al vector de relacion de direcciones del Noria */
-               norias.AddRelation (GetIndex(), srcMAC, srcIP);
-               if (n_writeAddressRelations) {
-                  norias.WriteAddressRelations (GetIndex());
-               }
-            }
-         }
-      }
-   }
-}
-
-/**
- * Recalculates the routing table according to the implementations of the OLSR's routing table calculation algorithm
- * found in src/olsr/model/olsr-routing-protocol.cc
- * Every timen when a new entre is going to be added in the routing table, a new condition is evaluated. It checks if the
- * r_next_addr is not in the list of the reserved nodes identified by the Noria. If the IP address is not registered as
- * reserved then the r_next_addr is added in the routing table as a next address, if not the entry is not added.
- */
-void Noria::RecalculateRoutingTable () {
-   NS_LOG_DEBUG (Simulator::Now().GetSeconds() << " s: Node " << n_olsr->m_mainAddress << ": RoutingTableComputation begin...");
-   
-   // 1. All the entries from the routing table are removed.
-   n_olsr->Clear ();
-   
-   // 2. The new routing entries are added starting with the
-   // symmetric neighbors (h=1) as the destination nodes.
-   const NeighborSet &neighborSet = n_olsr->m_state.GetNeighbors ();
-   for (NeighborSet::const_iterator it = neighborSet.begin (); it != neighborSet.end (); it++) {
-      NeighborTuple const &nb_tuple = *it;
-      NS_LOG_DEBUG ("Looking at neighbor tuple: " << nb_tuple);
-      if (nb_tuple.status == NeighborTuple::STATUS_SYM) {
-         bool nb_main_addr = false;
-         const LinkTuple *lt = NULL;
-         const LinkSet &linkSet = n_olsr->m_state.GetLinks ();
-         for (LinkSet::const_iterator it2 = linkSet.begin (); it2 != linkSet.end (); it2++) {
-            LinkTuple const &link_tuple = *it2;
-            NS_LOG_DEBUG ("Looking at link tuple: " << link_tuple << (link_tuple.time >= Simulator::Now () ? "" : " (expired)"));
-            if ((n_olsr->GetMainAddress (link_tuple.neighborIfaceAddr) == nb_tuple.neighborMainAddr) && link_tuple.time >= Simulator::Now ()) {
-               NS_LOG_LOGIC ("Link tuple matches neighbor " << nb_tuple.neighborMainAddr << " => adding routing table entry to neighbor");
-               lt = &link_tuple;
-               n_olsr->AddEntry (link_tuple.neighborIfaceAddr, link_tuple.neighborIfaceAddr, link_tuple.localIfaceAddr, 1);
-               if (link_tuple.neighborIfaceAddr == nb_tuple.neighborMainAddr) {
-                  nb_main_addr = true;
+               //El nodo no esta reservado
+               //El nodo no se encuentra reservado, por lo que su estado cambia a reservado
+               Reserve (now, srcIP, dstIP);
+               if (n_writeReservationState) {
+                  WriteReservationState ();
                }
             }
-            else {
-               NS_LOG_LOGIC ("Link tuple: linkMainAddress= " << n_olsr->GetMainAddress (link_tuple.neighborIfaceAddr)
-                                                             << "; neighborMainAddr =  " << nb_tuple.neighborMainAddr
-                                                             << "; expired=" << int (link_tuple.time < Simulator::Now ())
-                                                             << " => IGNORE");
-            }
-         }
-         
-         // If, in the above, no R_dest_addr is equal to the main
-         // address of the neighbor, then another new routing entry
-         // with MUST be added, with:
-         //      R_dest_addr  = main address of the neighbor;
-         //      R_next_addr  = L_neighbor_iface_addr of one of the
-         //                     associated link tuple with L_time >= current time;
-         //      R_dist       = 1;
-         //      R_iface_addr = L_local_iface_addr of the
-         //                     associated link tuple.
-         if (!nb_main_addr && lt != NULL) {
-            NS_LOG_LOGIC ("no R_dest_addr is equal to the main address of the neighbor "
-                            "=> adding additional routing entry");
-            n_olsr->AddEntry (nb_tuple.neighborMainAddr, lt->neighborIfaceAddr, lt->localIfaceAddr, 1);
-         }
-      }
-   }
-   
-   //  3. for each node in N2, i.e., a 2-hop neighbor which is not a
-   //  neighbor node or the node itself, and such that there exist at
-   //  least one entry in the 2-hop neighbor set where
-   //  N_neighbor_main_addr correspond to a neighbor node with
-   //  willingness different of WILL_NEVER,
-   const TwoHopNeighborSet &twoHopNeighbors = n_olsr->m_state.GetTwoHopNeighbors ();
-   for (TwoHopNeighborSet::const_iterator it = twoHopNeighbors.begin (); it != twoHopNeighbors.end (); it++) {
-      TwoHopNeighborTuple const &nb2hop_tuple = *it;
-      NS_LOG_LOGIC ("Looking at two-hop neighbor tuple: " << nb2hop_tuple);
-      
-      // a 2-hop neighbor which is not a neighbor node or the node itself
-      if (n_olsr->m_state.FindSymNeighborTuple (nb2hop_tuple.twoHopNeighborAddr)) {
-         NS_LOG_LOGIC ("Two-hop neighbor tuple is also neighbor; skipped.");
-         continue;
-      }
-      if (nb2hop_tuple.twoHopNeighborAddr == n_olsr->m_mainAddress) {
-         NS_LOG_LOGIC ("Two-hop neighbor is self; skipped.");
-         continue;
-      }
-      
-      // ...and such that there exist at least one entry in the 2-hop
-      // neighbor set where N_neighbor_main_addr correspond to a
-      // neighbor node with willingness different of WILL_NEVER...
-      bool nb2hopOk = false;
-      for (NeighborSet::const_iterator neighbor = neighborSet.begin (); neighbor != neighborSet.end (); neighbor++) {
-         if (neighbor->neighborMainAddr == nb2hop_tuple.neighborMainAddr && neighbor->willingness != OLSR_WILL_NEVER) {
-            nb2hopOk = true;
-            break;
          }
       }
-      if (!nb2hopOk) {
-         NS_LOG_LOGIC ("Two-hop neighbor tuple skipped: 2-hop neighbor "
-                        << nb2hop_tuple.twoHopNeighborAddr
-                        << " is attached to neighbor " << nb2hop_tuple.neighborMainAddr
-                        << ", which was not found in the Neighbor Set.");
-         continue;
-      }
-
-      // one selects one 2-hop tuple and creates one entry in the routing table with:
-      //                R_dest_addr  =  the main address of the 2-hop neighbor;
-      //                R_next_addr  = the R_next_addr of the entry in the
-      //                               routing table with:
-      //                                   R_dest_addr == N_neighbor_main_addr
-      //                                                  of the 2-hop tuple;
-      //                R_dist       = 2;
-      //                R_iface_addr = the R_iface_addr of the entry in the
-      //                               routing table with:
-      //                                   R_dest_addr == N_neighbor_main_addr
-      //                                                  of the 2-hop tuple;
-      RoutingTableEntry entry;
-      bool foundEntry = n_olsr->Lookup (nb2hop_tuple.neighborMainAddr, entry);
-      if (foundEntry && !n_reservednodes.Exist(entry.nextAddr)) { // MODIFICADO
-         NS_LOG_LOGIC ("Adding routing entry for two-hop neighbor.");
-         n_olsr->AddEntry (nb2hop_tuple.twoHopNeighborAddr, entry.nextAddr, entry.interface, 2);
-      }
       else {
-         NS_LOG_LOGIC ("NOT adding routing entry for two-hop neighbor (" << nb2hop_tuple.twoHopNeighborAddr << " not found in the routing table)");
-      }
-   }
-   
-   for (uint32_t h = 2;; h++) {
-      bool added = false;
-
-      // 3.1. For each topology entry in the topology table, if its
-      // T_dest_addr does not correspond to R_dest_addr of any
-      // route entry in the routing table AND its T_last_addr
-      // corresponds to R_dest_addr of a route entry whose R_dist
-      // is equal to h, then a new route entry MUST be recorded in
-      // the routing table (if it does not already exist)
-      const TopologySet &topology = n_olsr->m_state.GetTopologySet ();
-      for (TopologySet::const_iterator it = topology.begin (); it != topology.end (); it++) {
-         const TopologyTuple &topology_tuple = *it;
-         NS_LOG_LOGIC ("Looking at topology tuple: " << topology_tuple);
          
-         RoutingTableEntry destAddrEntry, lastAddrEntry;
-         bool have_destAddrEntry = n_olsr->Lookup (topology_tuple.destAddr, destAddrEntry);
-         bool have_lastAddrEntry = n_olsr->Lookup (topology_tuple.lastAddr, lastAddrEntry);
-         if (!have_destAddrEntry && have_lastAddrEntry && lastAddrEntry.distance == h  && !n_reservednodes.Exist(lastAddrEntry.nextAddr)) { // MODIFICADO
-            NS_LOG_LOGIC ("Adding routing table entry based on the topology tuple.");
-            // then a new route entry MUST be recorded in
-            //                the routing table (if it does not already exist) where:
-            //                     R_dest_addr  = T_dest_addr;
-            //                     R_next_addr  = R_next_addr of the recorded
-            //                                    route entry where:
-            //                                    R_dest_addr == T_last_addr
-            //                     R_dist       = h+1; and
-            //                     R_iface_addr = R_iface_addr of the recorded
-            //                                    route entry where:
-            //                                       R_dest_addr == T_last_addr.
-            n_olsr->AddEntry (topology_tuple.destAddr, lastAddrEntry.nextAddr, lastAddrEntry.interface, h + 1);
-            added = true;
-         }
-         else {
-            NS_LOG_LOGIC ("NOT adding routing table entry based on the topology tuple: "
-                            "have_destAddrEntry=" << have_destAddrEntry
-                                                  << " have_lastAddrEntry=" << have_lastAddrEntry
-                                                  << " lastAddrEntry.distance=" << (int) lastAddrEntry.distance
-                                                  << " (h=" << h << ")");
-         }
-      }
-      
-      if (!added) break;
-   }
-   
-   // 4. For each entry in the multiple interface association base
-   // where there exists a routing entry such that:
-   // R_dest_addr == I_main_addr (of the multiple interface association entry)
-   // AND there is no routing entry such that:
-   // R_dest_addr == I_iface_addr
-   const IfaceAssocSet &ifaceAssocSet = n_olsr->m_state.GetIfaceAssocSet ();
-   for (IfaceAssocSet::const_iterator it = ifaceAssocSet.begin (); it != ifaceAssocSet.end (); it++) {
-      IfaceAssocTuple const &tuple = *it;
-      RoutingTableEntry entry1, entry2;
-      bool have_entry1 = n_olsr->Lookup (tuple.mainAddr, entry1);
-      bool have_entry2 = n_olsr->Lookup (tuple.ifaceAddr, entry2);
-      if (have_entry1 && !have_entry2 && !n_reservednodes.Exist(entry1.nextAddr)) {     // MODIFICADO
-         // then a route entry is created in the routing table with:
-         //       R_dest_addr  =  I_iface_addr (of the multiple interface
-         //                                     association entry)
-         //       R_next_addr  =  R_next_addr  (of the recorded route entry)
-         //       R_dist       =  R_dist       (of the recorded route entry)
-         //       R_iface_addr =  R_iface_addr (of the recorded route entry).
-         n_olsr->AddEntry (tuple.ifaceAddr, entry1.nextAddr, entry1.interface, entry1.distance);
-      }
-   }
-   
-   // 5. For each tuple in the association set,
-   //    If there is no entry in the routing table with:
-   //        R_dest_addr     == A_network_addr/A_netmask
-   //   and if the announced network is not announced by the node itself,
-   //   then a new routing entry is created.
-   const AssociationSet &associationSet = n_olsr->m_state.GetAssociationSet ();
-   
-   // Clear HNA routing table
-   for (uint32_t i = 0; i < n_olsr->m_hnaRoutingTable->GetNRoutes (); i++) {
-      n_olsr->m_hnaRoutingTable->RemoveRoute (0);
-   }
-   
-   for (AssociationSet::const_iterator it = associationSet.begin (); it != associationSet.end (); it++) {
-      AssociationTuple const &tuple = *it;
-      
-      // Test if HNA associations received from other gateways
-      // are also announced by this node. In such a case, no route
-      // is created for this association tuple (go to the next one).
-      bool goToNextAssociationTuple = false;
-      const Associations &localHnaAssociations = n_olsr->m_state.GetAssociations ();
-      NS_LOG_DEBUG ("Nb local associations: " << localHnaAssociations.size ());
-      for (Associations::const_iterator assocIterator = localHnaAssociations.begin (); assocIterator != localHnaAssociations.end (); assocIterator++) {
-         Association const &localHnaAssoc = *assocIterator;
-         if (localHnaAssoc.networkAddr == tuple.networkAddr && localHnaAssoc.netmask == tuple.netmask) {
-            NS_LOG_DEBUG ("HNA association received from another GW is part of local HNA associations: no route added for network "
-                            << tuple.networkAddr << "/" << tuple.netmask);
-            goToNextAssociationTuple = true;
-         }
-      }
-      if (goToNextAssociationTuple) {
-         continue;
-      }
-      
-      RoutingTableEntry gatewayEntry;
-      bool gatewayEntryExists = n_olsr->Lookup (tuple.gatewayAddr, gatewayEntry);
-      bool addRoute = false;
-      uint32_t routeIndex = 0;
-      for (routeIndex = 0; routeIndex < n_olsr->m_hnaRoutingTable->GetNRoutes (); routeIndex++) {
-         Ipv4RoutingTableEntry route = n_olsr->m_hnaRoutingTable->GetRoute (routeIndex);
-         if (route.GetDestNetwork () == tuple.networkAddr && route.GetDestNetworkMask () == tuple.netmask) {
-            break;
+         // El nodo escucho el paquete (no es el destino a nivel de la capa de enlace)
+         // ¿El nodo que recibio el paquete es el destino de la transmision?
+         if (!n_relations.Related (dstMAC, dstIP)) {
+            
+            // ¿El destino del paquete es igual al destino de algun paquete enviado?
+            if (!ExistTransmission (dstIP)) {
+               
+               // Reservar el nodo que recibio el paquete pues hace parte del intermedio de una transmision
+               Ipv4Address ip = n_relations.GetIp (dstMAC);
+               if (n_relations.Exist (ip)) {
+                  AddReserved (ip, now);
+                  //RecalculateRoutingTable ();
+                  if (n_writeReservedNodes) {
+                     WriteReservedNodes ();
+                  }
+                  if (n_writeRoutingTable) {
+                     WriteRoutingTable ();
+                  }
+               }
+            }
          }
       }
+   }
+   else {
       
-      if (routeIndex == n_olsr->m_hnaRoutingTable->GetNRoutes ()) {
-         addRoute = true;
+      /* Se añade la informacion de las direcciones relacionadas al vector de relacion de direcciones del Noria */
+      AddRelation (srcMAC, srcIP);
+      if (n_writeAddressRelations) {
+         WriteAddressRelations ();
       }
-      else if (gatewayEntryExists && n_olsr->m_hnaRoutingTable->GetMetric (routeIndex) > gatewayEntry.distance) {
-         n_olsr->m_hnaRoutingTable->RemoveRoute (routeIndex);
-         addRoute = true;
+   }
+}
+
+/**
+ * Recalculates the routing table and writes it to OLSR in the same event
+ */
+void Noria::RecalculateRoutingTable () {
+   if (ComputeRoutingTable (Simulator::Now ())) {
+      ApplyRoutes ();
+   }
+}
+
+/**
+ * The node left the reserved set: the routes through it are expanded
+ * again, replacing the longer routes and adding the missing ones
+ */
+void Noria::ReleaseReservedRoutes (Ipv4Address ip) {
+   if (!n_computed) {
+      return;
+   }
+   if (!CanPatchRoutes ()) {
+      RequestRecalculation ();
+      return;
+   }
+   
+   std::vector<RoutingTableEntry> routes;
+   GetNextHopRoutes (ip, routes);
+   std::map<uint32_t, std::vector<RoutingTableEntry> > levels;                  //Rutas por el nodo liberado segun su distancia
+   for (uint32_t i = 0; i < routes.size (); i++) {
+      levels[routes[i].distance].push_back (routes[i]);
+   }
+   
+   // Vecinos de 2 saltos alcanzables a traves del nodo liberado
+   std::vector<Ipv4Address> changed;
+   const TwoHopNeighborSet &twoHopNeighbors = n_olsr->m_state.GetTwoHopNeighbors ();
+   for (TwoHopNeighborSet::const_iterator it = twoHopNeighbors.begin (); it != twoHopNeighbors.end (); it++) {
+      RoutingTableEntry entry, current;
+      if (!n_routes.Lookup (it->neighborMainAddr, entry) || !(entry.nextAddr == ip) || !IsTwoHopCandidate (*it)) {
+         continue;
       }
-      
-      if(addRoute && gatewayEntryExists) {
-         n_olsr->m_hnaRoutingTable->AddNetworkRouteTo (tuple.networkAddr, tuple.netmask, gatewayEntry.nextAddr, gatewayEntry.interface, gatewayEntry.distance);
+      if (!n_routes.Lookup (it->twoHopNeighborAddr, current) || current.distance > 2) {
+         SetRoute (it->twoHopNeighborAddr, entry.nextAddr, entry.interface, 2);
+         n_routes.Lookup (it->twoHopNeighborAddr, current);
+         levels[2].push_back (current);
+         changed.push_back (current.destAddr);
       }
    }
    
-   NS_LOG_DEBUG ("Node " << n_olsr->m_mainAddress << ": RoutingTableComputation end.");
-   n_olsr->m_routingTableChanged (n_olsr->GetSize ());
+   // Expansion por niveles desde las rutas por el nodo liberado
+   const TopologySet &topology = n_olsr->m_state.GetTopologySet ();
+   for (uint32_t h = 2; levels.lower_bound (h) != levels.end (); h++) {
+      std::vector<RoutingTableEntry> frontier;
+      frontier.swap (levels[h]);
+      std::vector<std::pair<uint32_t, uint32_t> > candidates;
+      for (uint32_t i = 0; i < frontier.size (); i++) {
+         const std::vector<uint32_t> &tuples = n_stateIndex.GetLastAddrTuples (frontier[i].destAddr);
+         for (uint32_t j = 0; j < tuples.size (); j++) {
+            candidates.push_back (std::make_pair (tuples[j], i));
+         }
+      }
+      std::sort (candidates.begin (), candidates.end ());
+      for (uint32_t i = 0; i < candidates.size (); i++) {
+         const TopologyTuple &topology_tuple = topology[candidates[i].first];
+         const RoutingTableEntry &lastAddrEntry = frontier[candidates[i].second];
+         RoutingTableEntry current;
+         if (!n_routes.Lookup (topology_tuple.destAddr, current) || current.distance > h + 1) {
+            SetRoute (topology_tuple.destAddr, lastAddrEntry.nextAddr, lastAddrEntry.interface, h + 1);
+            n_routes.Lookup (topology_tuple.destAddr, current);
+            levels[h + 1].push_back (current);
+            changed.push_back (current.destAddr);
+         }
+      }
+   }
    
-   //Indica cuando debe volver a calcular la tabla de enrutamiento
-   //Simulator::Schedule (Seconds(Commons::RESERVED_LIFETIME), &RecalculateTable, GetIndex());
+   // Las rutas copiadas a las interfaces de los destinos que cambiaron se vuelven a copiar
+   if (!changed.empty ()) {
+      std::sort (changed.begin (), changed.end ());
+      const IfaceAssocSet &ifaceAssocSet = n_olsr->m_state.GetIfaceAssocSet ();
+      for (IfaceAssocSet::const_iterator it = ifaceAssocSet.begin (); it != ifaceAssocSet.end (); it++) {
+         RoutingTableEntry entry;
+         if (std::binary_search (changed.begin (), changed.end (), it->mainAddr) 
+             && !std::binary_search (changed.begin (), changed.end (), it->ifaceAddr) 
+             && n_routes.Lookup (it->ifaceAddr, entry) && entry.distance > 1) {
+            n_routes.RemoveEntry (it->ifaceAddr);
+         }
+      }
+      AddIfaceAssocRoutes ();
+      AddAssociationRoutes ();
+   }
+   n_routesPatched = true;                      //Con rutas de igual distancia el calculo completo puede elegir otras
+   ApplyRoutes ();
+}
+
+/**
+ * Until the recalculation is done the routing table is not repaired, and the
+ * changes of the reserved nodes are left to the recalculation
+ */
+void Noria::RequestRecalculation (void) {
+   n_recalculationPending = true;
+   scheduler.Request (n_index);
 }
 
 /**
@@ -1013,7 +4097,10 @@ void Noria::Reserve (double t, Ipv4Address src, Ipv4Address dst) {
    n_reservedTime = t;                  //Almacena el tiempo (en segundos) en que se hizo la reserva
    n_rSrcAddress.Set(src.Get());        //Almacena la direccion IP origen de la transmision
    n_rDstAddress.Set(dst.Get());        //Almacena la direccion IP destino de la transmision
-   Simulator::Schedule (Seconds(Commons::RESERVED_LIFETIME), &ResetNoria, GetIndex());
+   if (n_resetTimes.empty ()) {
+      Simulator::Schedule (Seconds(Commons::RESERVED_LIFETIME), &ResetNoria, Ptr<Noria> (this));
+   }
+   n_resetTimes.push_back (Simulator::Now () + Seconds(Commons::RESERVED_LIFETIME));
 }
 
 /**
@@ -1034,59 +4121,154 @@ void Noria::Reset () {
 }
 
 /**
- *
+ * The node entered the reserved set: the routes of 2 or more hops through
+ * it are removed and their destinations are routed again without it. The
+ * routes through the other next hops are kept
  */
-void Noria::SendPacketProcess (Ptr<Packet> packet) {
-   double now = Simulator::Now ().GetSeconds ();        //Tiempo de simulacion (en segundos)
-   
-   /* WifiMac Header */
-   WifiMacHeader macHeader;             //Formato de cabecera WifiMAC
-   packet->RemoveHeader(macHeader);     //Obtener los datos de la cabecera WifiMAC
-   if (!macHeader.IsAck()) {            //Si no es un ACK
+void Noria::RestrictReservedRoutes (Ipv4Address ip) {
+   if (!n_computed) {
+      return;
+   }
+   if (!CanPatchRoutes ()) {
+      RequestRecalculation ();
+      return;
+   }
    
-      /* LLC/SNAP Header */
-      LlcSnapHeader llcHeader;                  //Formato de cabecera LLC
-      if (packet->PeekHeader(llcHeader) > 0) {  //Si el paquete contiene cabecera LLC/SNAP (Formalismo, pues si lo debe tener)
-         packet->RemoveHeader(llcHeader);       //Obtener los datos de la cabecera LLS/SNAP
+   std::vector<RoutingTableEntry> routes;
+   GetNextHopRoutes (ip, routes);
+   std::vector<Ipv4Address> lost;
+   for (uint32_t i = 0; i < routes.size (); i++) {
+      if (routes[i].distance >= 2) {
+         n_routes.RemoveEntry (routes[i].destAddr);
+         lost.push_back (routes[i].destAddr);
       }
-      
-      /* ARP Header */
-      ArpHeader arpHeader;                      //Formato de cabecera ARP
-      if (packet->PeekHeader(arpHeader) == 0) { //Si el paquete no contiene una cabecera ARP
-         
-         /* IPv4 Header */
-         Ipv4Header ipv4Header;                         //Formato de cabecera IPv4
-         if (packet->PeekHeader(ipv4Header) > 0) {      //Si el paquete contiene cabecera IPv4 (Formalismo, pues si lo debe tener)
-            packet->RemoveHeader(ipv4Header);           //Obtener los datos de la cabecera IPv4
+   }
+   if (!lost.empty ()) {
+      RouteLostDestinations (lost);
+      AddIfaceAssocRoutes ();
+      AddAssociationRoutes ();
+      n_routesPatched = true;                   //Con rutas de igual distancia el calculo completo puede elegir otras
+   }
+   else {
+      n_reservedFingerprint = n_reservednodes.GetFingerprint ();       //Ninguna ruta cambio: la tabla es la del calculo completo
+   }
+   ApplyRoutes ();
+}
+
+/**
+ * The table found moves to the front of the cache
+ */
+bool Noria::RestoreRoutes (const StateSnapshot &snapshot, uint64_t fingerprint, const std::vector<uint32_t> &reserved) {
+   for (std::deque<ComputedRoutes>::iterator it = n_routesCache.begin (); it != n_routesCache.end (); it++) {
+      if (it->c_reservedFingerprint == fingerprint && it->c_reservedAddresses == reserved && it->c_stateSnapshot == snapshot) {
+         n_routes = it->c_routes;
+         if (it != n_routesCache.begin ()) {
+            ComputedRoutes computed = *it;
+            n_routesCache.erase (it);
+            n_routesCache.push_front (computed);
          }
-         
-         /* UDP Header */
-         UdpHeader udpHeader;
-         if (packet->PeekHeader(udpHeader) > 0) {       //Si el paquete contiene cabecera UDP
-            
-            //Si el puerto UDP destino del paquete no es el mismo del protocolo OLSR
-            if (udpHeader.GetDestinationPort() != Commons::OLSR_PORT) { 
-               
-               // Se almacena el salto al que se envio el paquete
-               Mac48Address dstMAC = macHeader.GetAddr1();                              //Destination Address (IEEE 802.11 MAC header)
-               Ipv4Address ip = norias.GetRelatedIpAddress (GetIndex(), dstMAC);        //Direccion ip del nodo referenciado
-               norias.AddTransmission (GetIndex (), ip, now);                           //--------------------------------------------
-               
-               // Se almacena el destino y tiempo de transmision del paquete
-               Ipv4Address dstIP = ipv4Header.GetDestination(); //Direccion IP destino de la transmision
-               norias.AddTransmission (GetIndex(), dstIP, now); //--------------------------------------
+         return true;
+      }
+   }
+   return false;
+}
+
+/**
+ * Routes again the destinations without a route, following steps 3 and 3.1
+ * of the routing table calculation over the routes that were kept
+ */
+void Noria::RouteLostDestinations (const std::vector<Ipv4Address> &lost) {
+   std::unordered_map<uint32_t, std::vector<uint32_t> > pending;               //Tuplas de topologia de cada destino sin ruta
+   for (uint32_t i = 0; i < lost.size (); i++) {
+      pending[lost[i].Get ()];
+   }
+   
+   // 3. Vecinos de 2 saltos (la ultima tupla valida define la ruta)
+   std::vector<Ipv4Address> routed;
+   const TwoHopNeighborSet &twoHopNeighbors = n_olsr->m_state.GetTwoHopNeighbors ();
+   for (TwoHopNeighborSet::const_iterator it = twoHopNeighbors.begin (); it != twoHopNeighbors.end (); it++) {
+      if (pending.find (it->twoHopNeighborAddr.Get ()) == pending.end () || !IsTwoHopCandidate (*it)) {
+         continue;
+      }
+      RoutingTableEntry entry;
+      if (n_routes.Lookup (it->neighborMainAddr, entry) && !n_reservednodes.Exist (entry.nextAddr)) {
+         SetRoute (it->twoHopNeighborAddr, entry.nextAddr, entry.interface, 2);
+         routed.push_back (it->twoHopNeighborAddr);
+      }
+   }
+   for (uint32_t i = 0; i < routed.size (); i++) {
+      pending.erase (routed[i].Get ());
+   }
+   
+   // 3.1. Por niveles, cada destino toma la primera tupla cuyo T_last_addr tiene una ruta de distancia h
+   const TopologySet &topology = n_olsr->m_state.GetTopologySet ();
+   for (std::unordered_map<uint32_t, std::vector<uint32_t> >::iterator it = pending.begin (); it != pending.end (); it++) {
+      it->second = n_stateIndex.GetDestAddrTuples (Ipv4Address (it->first));
+   }
+   uint32_t maxDistance = 0;
+   for (uint32_t i = 0; i < n_routes.GetSize (); i++) {
+      maxDistance = std::max (maxDistance, n_routes.GetEntry (i).distance);
+   }
+   for (uint32_t h = 2; !pending.empty () && h <= maxDistance; h++) {
+      std::vector<std::pair<Ipv4Address, RoutingTableEntry> > added;
+      for (std::unordered_map<uint32_t, std::vector<uint32_t> >::const_iterator it = pending.begin (); it != pending.end (); it++) {
+         for (uint32_t i = 0; i < it->second.size (); i++) {
+            const TopologyTuple &topology_tuple = topology[it->second[i]];
+            RoutingTableEntry lastAddrEntry;
+            if (n_routes.Lookup (topology_tuple.lastAddr, lastAddrEntry) && lastAddrEntry.distance == h && !n_reservednodes.Exist (lastAddrEntry.nextAddr)) {
+               added.push_back (std::make_pair (topology_tuple.destAddr, lastAddrEntry));
+               break;
             }
          }
       }
+      for (uint32_t i = 0; i < added.size (); i++) {
+         SetRoute (added[i].first, added[i].second.nextAddr, added[i].second.interface, h + 1);
+         pending.erase (added[i].first.Get ());
+         maxDistance = std::max (maxDistance, h + 1);
+      }
+   }
+}
+
+/**
+ *
+ */
+void Noria::SendPacketProcess (const FrameInfo &frame) {
+   double now = Simulator::Now ().GetSeconds ();        //Tiempo de simulacion (en segundos)
+   
+   //Si el puerto UDP destino del paquete no es el mismo del protocolo OLSR
+   if (frame.f_dstPort != Commons::OLSR_PORT) { 
+      
+      // Se almacena el salto al que se envio el paquete
+      Mac48Address dstMAC = frame.f_dstMac;                                    //Destination Address (IEEE 802.11 MAC header)
+      Ipv4Address ip = GetRelatedIpAddress (dstMAC);                           //Direccion ip del nodo referenciado
+      AddTransmission (ip, now);                                               //--------------------------------------------
+      
+      // Se almacena el destino y tiempo de transmision del paquete
+      Ipv4Address dstIP = frame.f_dstIp;                //Direccion IP destino de la transmision
+      AddTransmission (dstIP, now);                     //--------------------------------------
    }
 }
 
+/**
+ *
+ */
+void Noria::SetRoute (Ipv4Address dest, Ipv4Address next, uint32_t interface, uint32_t distance) {
+   n_routes.AddEntry (dest, next, interface, distance);
+   n_nextHopRoutes[next.Get ()].push_back (dest);
+}
+
 /**
  *
  */
 void Noria::SetRecalculateRoutingTablePeriod (double period) {
    n_recalculateRoutingTablePeriod = period;
-   Simulator::Schedule (Seconds (period), &RecalculateTable, n_index);
+}
+
+/**
+ *
+ */
+void Noria::ShareRelations (bool enable) {
+   n_relations.SetShared (enable);
 }
 
 /**
@@ -1108,11 +4290,32 @@ void Noria::ShowRelations () {
    std::cout << std::endl;
 }
 
+/**
+ * The least recently used table leaves the cache when it is full
+ */
+void Noria::StoreRoutes (const StateSnapshot &snapshot, uint64_t fingerprint, const std::vector<uint32_t> &reserved) {
+   n_routesCache.push_front (ComputedRoutes (snapshot, fingerprint, reserved, n_routes));
+   if (n_routesCache.size () > Commons::ROUTES_CACHE_CAPACITY) {
+      n_routesCache.pop_back ();
+   }
+}
+
+/**
+ *
+ */
+void Noria::TraceOlsrPackets (bool enable) {
+   n_traceOlsr = enable;
+}
+
 /**
  *
  */
 void Noria::UpdateReservedNodes (double time) {
-   n_reservednodes.Update (time);
+   std::vector<Ipv4Address> expired;
+   n_reservednodes.Update (time, expired);
+   for (uint32_t i = 0; i < expired.size (); i++) {
+      ReleaseReservedRoutes (expired[i]);
+   }
 }
 
 /**
@@ -1245,266 +4448,540 @@ void Noria::WriteTransmissions (void) {
 /**
  *
  */
-NoriaContainer::NoriaContainer (void) {
+NoriaContainer::NoriaContainer (void) : 
+   m_denseForwarding (false), 
+   m_lazyOlsrDecoding (false), 
+   m_receiveOlsr (false), 
+   m_shareRelations (false), 
+   m_traceOlsr (true), 
+   m_recalculationThreads (0), 
+   m_transmissionLifetime (Commons::TRANSMISSION_LIFETIME), 
+   m_transmissionCapacity (Commons::TRANSMISSION_CAPACITY), 
+   m_batchNext (0), 
+   m_batchNumber (0), 
+   m_batchWorking (0), 
+   m_stopWorkers (false) 
+{
 }
 
 /**
  *
  */
-void NoriaContainer::Add (Noria noria) {
-   m_norias.push_back (noria);
+NoriaContainer::~NoriaContainer (void) {
+   StopWorkers ();
 }
 
 /**
  *
  */
-void NoriaContainer::AddRelation (uint32_t index, Mac48Address mac, Ipv4Address ip) {
-   m_norias[index].AddRelation (mac, ip);
+void NoriaContainer::Add (Ptr<Noria> noria) {
+   m_norias.push_back (noria);
 }
 
 /**
  *
  */
-void NoriaContainer::AddReserved (uint32_t index, Ipv4Address ip, double time) {
-   m_norias[index].AddReserved (ip, time);
+NoriaContainer::Iterator NoriaContainer::Begin (void) const {
+   return m_norias.begin ();
 }
 
+
 /**
  *
  */
-void NoriaContainer::AddTransmission (uint32_t index, Ipv4Address ip, double time) {
-   m_norias[index].AddTransmission (ip, time);
+void NoriaContainer::Clear (void) {
+   m_norias.clear ();
 }
 
 /**
  *
  */
-void NoriaContainer::Clear (void) {
-   m_norias.clear ();
+void NoriaContainer::ComputeRoutingTables (void) {
+   while (true) {
+      uint32_t i;
+      {
+         CriticalSection section (m_batchMutex);
+         i = m_batchNext++;
+      }
+      if (i >= m_norias.size ()) {
+         return;
+      }
+      v_batchComputed[i] = m_norias[i]->ComputeRoutingTable (m_batchTime);
+   }
 }
 
 /**
  *
  */
-void NoriaContainer::EraseReservedNode (uint32_t noriaIndex, uint32_t reservedIndex) {
-   m_norias[noriaIndex].EraseReservedNode (reservedIndex);
+NoriaContainer::Iterator NoriaContainer::End (void) const {
+   return m_norias.end ();
 }
 
 /**
  *
  */
-void NoriaContainer::EraseTransmission (uint32_t index, Ipv4Address ip) {
-   m_norias[index].EraseTransmission (ip);
+void NoriaContainer::DenseForwarding (bool enable) {
+   m_denseForwarding = enable;
 }
 
 /**
  *
  */
-bool NoriaContainer::ExistTransmission (uint32_t index, Ipv4Address ip) {
-   return m_norias[index].ExistTransmission (ip);
+void NoriaContainer::ExpireTransmissions (double time) {
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->ExpireTransmissions (time);
+   }
 }
 
 /**
  *
  */
-Noria NoriaContainer::Get (uint32_t i) const {
+Ptr<Noria> NoriaContainer::Get (uint32_t i) const {
    return m_norias[i];
 }
 
 /**
- * 
+ *
+ */
+uint32_t NoriaContainer::GetSize (void) const {
+   return m_norias.size ();
+}
+
+/**
+ *
  */
-uint32_t NoriaContainer::GetNoriaIndex (Mac48Address address) {
-   uint32_t i = 0;
-   uint32_t nNorias = GetSize();
-   bool found = false;
-   while (!found && i < nNorias) {
-      if (address == m_norias[i].GetMacAddress()) {
-         found = true;
-      }
-      else {
-         i += 1;
-      }
+void NoriaContainer::Install (NodeContainer c, Ipv4InterfaceContainer interfaces) {
+   uint32_t cont = 0;
+   addresses.Clear ();
+   for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i) {
+      Mac48Address macAddress = Mac48Address::ConvertFrom ((*i)->GetDevice (0)->GetAddress ());       // Direccion MAC del primer dispositivo del nodo
+      addresses.Add (macAddress, interfaces.GetAddress (cont));                                         // Identificador de las direcciones del nodo
+      cont += 1;
+   }
+   
+   cont = 0;
+   m_norias.reserve (m_norias.size () + c.GetN ());
+   for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i) {
+      Ipv4Address ipAddress = interfaces.GetAddress (cont);
+      Ptr<Noria> agent = Create<Noria> ();
+      agent->DenseForwarding (m_denseForwarding);
+      agent->LazyOlsrDecoding (m_lazyOlsrDecoding);
+      agent->LimitTransmissions (m_transmissionLifetime, m_transmissionCapacity);
+      agent->ReceiveOlsrPackets (m_receiveOlsr);
+      agent->ShareRelations (m_shareRelations);
+      agent->TraceOlsrPackets (m_traceOlsr);
+      agent->Install (cont, ipAddress);
+      Add (agent);
+      cont += 1;
+   }
+   
+   // Un solo evento barre los registros de todos los agentes
+   Simulator::Schedule (Seconds (Commons::RESERVED_LIFETIME), &UpdateReserved);
+   if (m_transmissionLifetime > 0) {
+      Simulator::Schedule (Seconds (m_transmissionLifetime), &AgeTransmissions, m_transmissionLifetime);
    }
-   return i;
 }
 
 /**
  *
  */
-double NoriaContainer::GetRecalculateRoutingTablePeriod (uint32_t index) {
-   return m_norias[index].GetRecalculateRoutingTablePeriod ();
+void NoriaContainer::LazyOlsrDecoding (bool enable) {
+   m_lazyOlsrDecoding = enable;
 }
 
 /**
  *
  */
-Ipv4Address NoriaContainer::GetRelatedIpAddress (uint32_t index, Mac48Address mac) {
-   return m_norias[index].GetRelatedIpAddress (mac);
+void NoriaContainer::LimitTransmissions (double lifetime, uint32_t capacity) {
+   m_transmissionLifetime = lifetime;
+   m_transmissionCapacity = capacity;
+}
+
+/**
+ * The agents are not copied while the threads use them: the Ptr copies
+ * would change their (not atomic) reference counts. The calculation logs
+ * (NS_LOG) are not thread safe, so while they are enabled the batch is
+ * computed by the simulator thread alone
+ */
+void NoriaContainer::RecalculateRoutingTables (void) {
+   uint32_t n = m_norias.size ();
+   addresses.Build ();                 //Los hilos solo leen la tabla de direcciones
+   bool parallel = m_recalculationThreads > 1 && n > 1;
+#ifdef NS3_LOG_ENABLE
+   if (g_log.IsEnabled (LOG_DEBUG) || g_log.IsEnabled (LOG_LOGIC)) {
+      parallel = false;
+   }
+#endif
+   if (parallel) {
+      StartWorkers ();
+   }
+   {
+      CriticalSection section (m_batchMutex);
+      m_batchTime = Simulator::Now ();
+      m_batchNext = 0;
+      v_batchComputed.assign (n, 0);
+      if (parallel) {
+         m_batchNumber += 1;
+         m_batchWorking = v_workers.size ();
+      }
+   }
+   if (parallel) {
+      m_batchStart.SetCondition (true);
+      m_batchStart.Broadcast ();
+   }
+   ComputeRoutingTables ();            //El hilo del simulador tambien calcula tablas
+   while (parallel) {
+      {
+         CriticalSection section (m_batchMutex);
+         if (m_batchWorking == 0) {
+            break;
+         }
+      }
+      m_batchDone.TimedWait (BATCH_WAIT_NS);
+   }
+   for (uint32_t i = 0; i < n; i++) {
+      if (v_batchComputed[i]) {
+         m_norias[i]->ApplyRoutes ();
+      }
+   }
 }
 
 /**
  *
  */
-uint32_t NoriaContainer::GetSize (void) const {
-   return m_norias.size ();
+void NoriaContainer::ReceiveOlsrPackets (bool enable) {
+   m_receiveOlsr = enable;
 }
 
 /**
  *
  */
-double NoriaContainer::GetTransmissionTime (uint32_t index, Ipv4Address ip) {
-   return m_norias[index].GetTransmissionTime (ip);
+void NoriaContainer::RunWorker (void) {
+   uint64_t computed = 0;                                      //Ultimo lote calculado por el hilo
+   while (true) {
+      bool start = false;
+      {
+         CriticalSection section (m_batchMutex);
+         if (m_stopWorkers) {
+            return;
+         }
+         if (m_batchNumber != computed) {
+            computed = m_batchNumber;
+            start = true;
+         }
+      }
+      if (!start) {
+         m_batchStart.TimedWait (BATCH_WAIT_NS);
+         continue;
+      }
+      ComputeRoutingTables ();
+      bool last;
+      {
+         CriticalSection section (m_batchMutex);
+         m_batchWorking -= 1;
+         last = m_batchWorking == 0;
+      }
+      if (last) {
+         m_batchDone.SetCondition (true);
+         m_batchDone.Signal ();
+      }
+   }
 }
 
 /**
  *
  */
-void NoriaContainer::Install (NodeContainer c, Ipv4InterfaceContainer interfaces) {
-   uint32_t cont = 0;
-   for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i) {
-      Ipv4Address ipAddress = interfaces.GetAddress (cont);
-      Noria agent;
-      agent.Install (cont, ipAddress);
-      Add (agent);
-      cont += 1;
+void NoriaContainer::SetRecalculateRoutingTablePeriod (double period) {
+   scheduler.Clear ();
+   scheduler.SetBatch (m_recalculationThreads > 0);
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->SetRecalculateRoutingTablePeriod (period);
+      scheduler.Add (*i);
+   }
+   scheduler.Start (period);
+   if (m_recalculationThreads > 0) {
+      Simulator::Schedule (Seconds (period), &RecalculateTables, period);
    }
 }
 
 /**
  *
  */
-bool NoriaContainer::IsReserved (uint32_t index) {
-   return m_norias[index].IsReserved ();
+void NoriaContainer::SetRecalculationThreads (uint32_t threads) {
+   m_recalculationThreads = threads;
 }
 
 /**
  *
  */
-void NoriaContainer::RecalculateRoutingTable (uint32_t index) {
-   m_norias[index].RecalculateRoutingTable ();
+void NoriaContainer::ShareRelations (bool enable) {
+   m_shareRelations = enable;
 }
 
 /**
  *
  */
-void NoriaContainer::ReceivePacketProcess (uint32_t index, Ptr<Packet> packet) {
-   m_norias[index].ReceivePacketProcess (packet);
+void NoriaContainer::ShowConfig () {
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->ShowConfig ();
+   }
+}
+
+/**
+ * The simulator thread is one of the m_recalculationThreads
+ */
+void NoriaContainer::StartWorkers (void) {
+   while (v_workers.size () + 1 < m_recalculationThreads) {
+      v_workers.push_back (Create<SystemThread> (MakeCallback (&NoriaContainer::RunWorker, this)));
+      v_workers.back ()->Start ();
+   }
 }
 
 /**
  *
  */
-void NoriaContainer::Reserve (uint32_t index, double now, Ipv4Address srcIP, Ipv4Address dstIP) {
-   m_norias[index].Reserve (now, srcIP, dstIP);
+void NoriaContainer::StopWorkers (void) {
+   {
+      CriticalSection section (m_batchMutex);
+      m_stopWorkers = true;
+   }
+   m_batchStart.SetCondition (true);
+   m_batchStart.Broadcast ();
+   for (uint32_t i = 0; i < v_workers.size (); i++) {
+      v_workers[i]->Join ();
+   }
+   v_workers.clear ();
+   m_stopWorkers = false;              //Los hilos ya terminaron, el siguiente lote los crea de nuevo
 }
 
 /**
  *
  */
-void NoriaContainer::Reset (uint32_t index) {
-   m_norias[index].Reset ();
+void NoriaContainer::TraceOlsrPackets (bool enable) {
+   m_traceOlsr = enable;
 }
 
 /**
  *
  */
-void NoriaContainer::SendPacketProcess (uint32_t index, Ptr<Packet> packet) {
-   m_norias[index].SendPacketProcess (packet);
+void NoriaContainer::UpdateReservedNodes (double time) {
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->UpdateReservedNodes (time);
+   }
 }
 
 /**
  *
  */
-void NoriaContainer::SetRecalculateRoutingTablePeriod (double period) {
-   uint32_t n = GetSize();
-   for (uint32_t i = 0;i < n;i += 1) {
-      m_norias[i].SetRecalculateRoutingTablePeriod (period);
+void NoriaContainer::WriteAddressRelations (bool enable) {
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->WriteAddressRelations (enable);
    }
 }
 
 /**
  *
  */
-void NoriaContainer::SetRecalculateRoutingTablePeriod (uint32_t index, double period) {
-   m_norias[index].SetRecalculateRoutingTablePeriod (period);
+void NoriaContainer::WriteOlsrMessages (void) {
+   std::ofstream write((filePrefix + Commons::olsrRegistry).c_str());
+   write << "Noria"    << Commons::csvSymbol 
+         << "Messages" << Commons::csvSymbol 
+         << "Decoded"  << Commons::csvSymbol 
+         << "TupleChecks" << Commons::csvSymbol 
+         << "SweepEvents" << std::endl;
+   for (Iterator i = Begin (); i != End (); ++i) {
+      write << (*i)->GetIndex () << Commons::csvSymbol 
+            << (*i)->GetOlsrReceiver ().GetMessages () << Commons::csvSymbol 
+            << (*i)->GetOlsrReceiver ().GetDecodedMessages () << Commons::csvSymbol 
+            << (*i)->GetOlsrReceiver ().GetSweeper ().GetChecks () << Commons::csvSymbol 
+            << (*i)->GetOlsrReceiver ().GetSweeper ().GetSweeps () << std::endl;
+   }
+   write.close();
 }
 
 /**
  *
  */
-void NoriaContainer::ShowConfig () {
-   uint32_t nNorias = GetSize ();
-   for (uint32_t i = 0;i < nNorias;i += 1) {
-      m_norias[i].ShowConfig ();
+void NoriaContainer::WriteRecalculations (void) {
+   std::ofstream write((filePrefix + Commons::recalculationRegistry).c_str());
+   write << "Noria"    << Commons::csvSymbol 
+         << "Executed" << Commons::csvSymbol 
+         << "Reused"   << Commons::csvSymbol 
+         << "Skipped"  << std::endl;
+   for (Iterator i = Begin (); i != End (); ++i) {
+      write << (*i)->GetIndex () << Commons::csvSymbol 
+            << (*i)->GetRecalculations () << Commons::csvSymbol 
+            << (*i)->GetReusedRecalculations () << Commons::csvSymbol 
+            << (*i)->GetSkippedRecalculations () << std::endl;
    }
+   write.close();
 }
 
 /**
  *
  */
-void NoriaContainer::UpdateReservedNodes (uint32_t index, double time) {
-   m_norias[index].UpdateReservedNodes (time);
+void NoriaContainer::WriteReservationState (bool enable) {
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->WriteReservationState (enable);
+   }
 }
 
 /**
  *
  */
-void NoriaContainer::UpdateTransmissionTime (uint32_t index, Ipv4Address ip, double time) {
-   m_norias[index].UpdateTransmission (ip, time);
+void NoriaContainer::WriteReservedNodes (bool enable) {
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->WriteReservedNodes (enable);
+   }
 }
 
 /**
  *
  */
-void NoriaContainer::WriteAddressRelations (bool enable) {
-   uint32_t nNorias = GetSize ();
-   for (uint32_t i = 0;i < nNorias;i += 1) {
-      m_norias[i].WriteAddressRelations (enable);
+void NoriaContainer::WriteRoutingTables (bool enable) {
+   for (Iterator i = Begin (); i != End (); ++i) {
+      (*i)->WriteRoutingTable (enable);
    }
 }
 
+/**
+ * +-------------------------------------------------------------------------+
+ * | Clase RecalculationScheduler                                            |
+ * +-------------------------------------------------------------------------+
+ */
+
+/**
+ *
+ */
+RecalculationScheduler::RecalculationScheduler (void) : 
+   m_period (0), 
+   m_minInterval (0), 
+   m_batch (false) 
+{
+}
+
 /**
  *
  */
-void NoriaContainer::WriteReservationState (bool enable) {
-   uint32_t nNorias = GetSize ();
-   for (uint32_t i = 0;i < nNorias;i += 1) {
-      m_norias[i].WriteReservationState (enable);
+void RecalculationScheduler::Add (Ptr<Noria> noria) {
+   v_norias.push_back (noria);
+}
+
+/**
+ * The slot that has just passed (or that the event of the agent is for)
+ * is compared in simulation time, as the event was scheduled
+ */
+void RecalculationScheduler::AdvanceSlot (uint32_t index) {
+   Time now = Simulator::Now ();
+   while (Seconds (GetSlotTime (index)) <= now) {
+      v_slots[index] += 1;
    }
 }
 
 /**
  *
  */
-void NoriaContainer::WriteReservationState (uint32_t index) {
-   m_norias[index].WriteReservationState ();
+void RecalculationScheduler::Clear (void) {
+   v_norias.clear ();
+   v_events.clear ();
+   v_times.clear ();
+   v_offsets.clear ();
+   v_slots.clear ();
+}
+
+/**
+ * The same agent always gets the same jitter, so the runs are repeatable
+ */
+double RecalculationScheduler::GetJitter (uint32_t index) {
+   uint64_t x = index + 0x9e3779b97f4a7c15ULL;
+   x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+   x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+   x = x ^ (x >> 31);
+   return (x >> 11) * (1.0 / 9007199254740992.0);                     //53 bits de mantisa
+}
+
+/**
+ * The periodic recalculations of the agent are at offset + k * period, k >= 1
+ */
+double RecalculationScheduler::GetSlotTime (uint32_t index) {
+   return v_offsets[index] + v_slots[index] * m_period;
+}
+
+/**
+ * If the event was the periodic recalculation, its slot is over and the
+ * next one is scheduled. If it was moved forward by a request, the
+ * periodic recalculation is still pending
+ */
+void RecalculationScheduler::Recalculate (uint32_t index) {
+   v_norias[index]->RecalculateRoutingTable ();
+   AdvanceSlot (index);
+   Schedule (index, GetSlotTime (index));
+}
+
+/**
+ * If the agent waits, its pending event is moved forward when the interval
+ * ends before the next periodic recalculation, and it is left as it is in
+ * other case (both recalculations are joined)
+ */
+void RecalculationScheduler::Request (uint32_t index) {
+   double now = Simulator::Now ().GetSeconds ();
+   double earliest = v_norias[index]->GetLastRecalculation () + m_minInterval;
+   if (earliest <= now) {
+      v_norias[index]->RecalculateRoutingTable ();
+      return;
+   }
+   if (!m_batch && index < v_times.size () && earliest < v_times[index]) {
+      Schedule (index, earliest);
+   }
 }
 
 /**
  *
  */
-void NoriaContainer::WriteReservedNodes (bool enable) {
-   uint32_t nNorias = GetSize ();
-   for (uint32_t i = 0;i < nNorias;i += 1) {
-      m_norias[i].WriteReservedNodes (enable);
+void RecalculationScheduler::Schedule (uint32_t index, double time) {
+   Time now = Simulator::Now ();
+   Time at = Seconds (time);                    //Tiempo del evento, redondeado como el de la simulacion
+   if (at <= now) {
+      at = now + TimeStep (1);
    }
+   v_events[index].Cancel ();
+   v_times[index] = at.GetSeconds ();
+   v_events[index] = Simulator::Schedule (at - now, &RecalculationScheduler::Recalculate, this, index);
 }
 
 /**
  *
  */
-void NoriaContainer::WriteRoutingTable (uint32_t index) {
-   m_norias[index].WriteRoutingTable ();
+void RecalculationScheduler::SetBatch (bool batch) {
+   m_batch = batch;
 }
 
 /**
  *
  */
-void NoriaContainer::WriteRoutingTables (bool enable) {
-   uint32_t nNorias = GetSize ();
-   for (uint32_t i = 0;i < nNorias;i += 1) {
-      m_norias[i].WriteRoutingTable (enable);
+void RecalculationScheduler::SetMinInterval (double interval) {
+   m_minInterval = interval;
+}
+
+/**
+ * The period is split in one slot per agent, and each agent recalculates
+ * at a jittered point of its slot
+ */
+void RecalculationScheduler::Start (double period) {
+   double now = Simulator::Now ().GetSeconds ();
+   uint32_t n = v_norias.size ();
+   m_period = period;
+   v_events.assign (n, EventId ());
+   v_times.assign (n, 0);
+   v_offsets.assign (n, 0);
+   v_slots.assign (n, 1);
+   for (uint32_t i = 0; i < n; i++) {
+      v_offsets[i] = period * (i + GetJitter (i)) / n;
+      v_slots[i] = (uint64_t) std::max (1.0, std::floor ((now - v_offsets[i]) / period) + 1);
+      AdvanceSlot (i);
+      if (!m_batch) {
+         Schedule (i, GetSlotTime (i));
+      }
    }
 }
 
@@ -1525,18 +5002,27 @@ NoriaSimulation::NoriaSimulation () :
    areaWidth (500.0),                   //Anchura del terreno de simulacion
    bytesTotal (0),                      //Total de bytes transmitidos
    dataRate ("2048bps"),                //Tasa de datos
+   denseForwarding (false),             //Indica si los Noria enrutan los paquetes con la copia densa de la tabla de OLSR
    installNorias (true),                // Indica si se instalan los Noria en los nodos
+   lazyOlsrDecoding (false),            //Indica si los Noria decodifican solo los mensajes OLSR que procesan o reenvian
+   minRecalculationInterval (0),        //Tiempo minimo entre recalculos solicitados por reservas
    mTxp (7.5),                          //---------------------------------------
    nNodes (50),                         //Numero de nodos
    nodePause (0),                       //Pausa del movimiento de los nodos (en segundos)
    nodeSpeed (1.5),                     //Velocidad de movimiento de los nodos (m/s)
    nSinks (10),                         //Numero de sinks
+   olsrReceiver (false),                //Indica si los paquetes OLSR son recibidos por los Noria
+   olsrRxTrace (false),                 //Indica si los Noria disparan la traza Rx de OLSR
    packetsReceived (0),                 //Paquetes recibidos
    phyMode ("DsssRate11Mbps"),          //---------------------------------------
    port (9),                            //Puerto de comunicacion
    recalculatePeriod (2.0),             //Periodo de recalculacion de las tablas de enrutamiento
+   recalculationThreads (0),            //Hilos de recalculacion en lote de las tablas de enrutamiento
+   shareRelations (false),              //Indica si los Noria comparten las relaciones de direcciones
    totalTime (200.0),                   //---------------------------------------
    traceMobility (false),               //Rastrear movilidad
+   transmissionCapacity (Commons::TRANSMISSION_CAPACITY),       //Numero maximo de destinos recordados por cada Noria
+   transmissionLifetime (Commons::TRANSMISSION_LIFETIME),       //Tiempo que un Noria recuerda un destino
    writeAddressRelations (false),       //---------------------------------------
    writeAsciiFiles (false),             //---------------------------------------
    writeMobilityFiles (false),          //---------------------------------------
@@ -1672,6 +5158,9 @@ void NoriaSimulation::Run () {
    
    InitFiles();         // Inicio de los archivos
    norias.Clear();      // Limpia el contenedor de Norias
+   scheduler.Clear();   // Descarta los recalculos planificados
+   filter.Clear();      // Reinicia los contadores del filtro de tramas
+   tap.Clear();         // Descarta las transmisiones decodificadas
 
    Packet::EnableChecking ();                                                                   //---------------------------------------
    Config::SetDefault ("ns3::OnOffApplication::PacketSize", StringValue ("64"));                //---------------------------------------
@@ -1732,7 +5221,15 @@ void NoriaSimulation::Run () {
    mobilityAdhoc.Install (adHocNodes);                                                                  //Instala en los nodos adHoc la movilidad
    
    if (installNorias) {
+      norias.ShareRelations (shareRelations);                                           //Indica si los Noria comparten las relaciones de direcciones
+      norias.ReceiveOlsrPackets (olsrReceiver);                                         //Indica si los Noria reciben los paquetes OLSR
+      norias.LazyOlsrDecoding (lazyOlsrDecoding);                                       //Indica si los Noria decodifican solo los mensajes OLSR que procesan o reenvian
+      norias.TraceOlsrPackets (olsrRxTrace);                                            //Indica si los Noria disparan la traza Rx de OLSR
+      norias.DenseForwarding (denseForwarding);                                         //Indica si los Noria enrutan los paquetes con la copia densa de la tabla de OLSR
+      norias.LimitTransmissions (transmissionLifetime, transmissionCapacity);          //Indica cuanto tiempo y cuantos destinos recuerdan los Noria
       norias.Install (adHocNodes, adHocInterfaces);                                     //Instala los Noria en los nodos indicados
+      scheduler.SetMinInterval (minRecalculationInterval);                              //Indica el tiempo minimo entre recalculos solicitados por reservas
+      norias.SetRecalculationThreads (recalculationThreads);                            //Indica cuantos hilos recalculan en lote las tablas de enrutamiento
       norias.SetRecalculateRoutingTablePeriod (recalculatePeriod);                      //Indica el tiempo de espera para recalcular las tablas de enrutamiento
       if (writeAddressRelations) norias.WriteAddressRelations (writeAddressRelations);  //Indica si se registran en archivo las relaciones de direcciones
       if (writeReservationState) norias.WriteReservationState (writeReservationState);  //Indica si se registran en archivo los estados de reserva de los nodos
@@ -1774,13 +5271,18 @@ void NoriaSimulation::Run () {
    WriteConfig ();                                                              //---------------------------------------
    Simulator::Run ();                                                           //Inicia la simulacion
    flowmon->SerializeToXmlFile ((filePrefix + Commons::flowRegistry).c_str (), false, false);  //---------------------------------------
+   if (installNorias) filter.Write ();                                          //Registra en archivo los contadores del filtro de tramas
+   if (installNorias) tap.Write ();                                             //Registra en archivo los contadores de las transmisiones decodificadas
+   if (installNorias) norias.WriteRecalculations ();                            //Registra en archivo los recalculos ejecutados y omitidos de cada Noria
+   if (installNorias && (olsrReceiver || lazyOlsrDecoding)) norias.WriteOlsrMessages ();  //Registra en archivo los mensajes OLSR recibidos y decodificados de cada Noria
+   if (installNorias) norias.StopWorkers ();                                    //Termina los hilos de recalculacion antes de la siguiente simulacion
    Simulator::Destroy ();                                                       //Una vez finalizada destruye la simulacion
 }
 
 /**
  *
  */
-void NoriaSimulation::SetParameters (double height, double width, uint32_t nodes, uint32_t sinks, bool norias, double recalculateTime, double time, bool mobility, bool addressRelations, bool asciiFiles, bool mobilityFiles, bool pcapFiles, bool reservationState, bool reservedNodes, bool routingTables) {
+void NoriaSimulation::SetParameters (double height, double width, uint32_t nodes, uint32_t sinks, bool norias, double recalculateTime, double time, bool mobility, bool addressRelations, bool asciiFiles, bool mobilityFiles, bool pcapFiles, bool reservationState, bool reservedNodes, bool routingTables, bool sharedRelations, uint32_t threads, double minInterval, bool receiveOlsr, bool lazyOlsr, bool rxTrace, bool denseTable, double lifetime, uint32_t capacity) {
    areaHeight = height;                         //------------------------------
    areaWidth = width;                           //------------------------------
    nNodes = nodes;                              //------------------------------
@@ -1796,6 +5298,15 @@ void NoriaSimulation::SetParameters (double height, double width, uint32_t nodes
    writeReservationState = reservationState;    //------------------------------
    writeReservedNodes = reservedNodes;          //------------------------------
    writeRoutingTables = routingTables;          //------------------------------
+   shareRelations = sharedRelations;            //------------------------------
+   recalculationThreads = threads;              //------------------------------
+   minRecalculationInterval = minInterval;      //------------------------------
+   olsrReceiver = receiveOlsr;                  //------------------------------
+   lazyOlsrDecoding = lazyOlsr;                 //------------------------------
+   olsrRxTrace = rxTrace;                       //------------------------------
+   denseForwarding = denseTable;                //------------------------------
+   transmissionLifetime = lifetime;             //------------------------------
+   transmissionCapacity = capacity;             //------------------------------
 }
 
 /**
@@ -1810,8 +5321,19 @@ void NoriaSimulation::WriteConfig () {
    std::cout << "Sinks: " << nSinks << std::endl;
    std::cout << "Tiempo total de simulacion: " << totalTime << " segundos" << std::endl;
    std::cout << "Periodo de recalculacion de tablas de enrutamiento: " << recalculatePeriod << " segundos" << std::endl;
+   std::cout << "Relaciones compartidas: " << ((shareRelations) ? "Si" : "No") << std::endl;
+   std::cout << "Hilos de recalculacion: " << recalculationThreads << std::endl;
+   std::cout << "Intervalo minimo entre recalculos: " << minRecalculationInterval << " segundos" << std::endl;
+   std::cout << "Receptor OLSR de los Noria: " << ((olsrReceiver) ? "Si" : "No") << std::endl;
+   std::cout << "Decodificacion perezosa de OLSR: " << ((lazyOlsrDecoding) ? "Si" : "No") << std::endl;
+   std::cout << "Traza Rx de OLSR: " << ((olsrRxTrace) ? "Si" : "No") << std::endl;
+   std::cout << "Tabla densa de reenvio: " << ((denseForwarding) ? "Si" : "No") << std::endl;
+   std::cout << "Tiempo de vida de las transmisiones: " << transmissionLifetime << " segundos" << std::endl;
+   std::cout << "Capacidad de las transmisiones: " << transmissionCapacity << std::endl;
 }
 
+#ifndef NORIA_TEST
+
 /**
  *
  */
@@ -1819,14 +5341,23 @@ int main (int argc, char *argv[]) {
 
    double areaHeight = 500.0;
    double areaWidth = 500.0;
+   bool denseForwarding = false;
    uint32_t endNodes = 80;
    uint32_t initNodes = 20;
+   bool lazyOlsrDecoding = false;
+   double minRecalculationInterval = 0;
    uint32_t nodeIncrement = 10;
    uint32_t nSinks = 10;
+   bool olsrReceiver = false;
+   bool olsrRxTrace = false;
    uint32_t port = 9;
    double recalculatePeriod = 2.0;
+   uint32_t recalculationThreads = 0;
+   bool shareRelations = false;
    double totalTime = 200.0;
    bool traceMobility = false;
+   uint32_t transmissionCapacity = Commons::TRANSMISSION_CAPACITY;
+   double transmissionLifetime = Commons::TRANSMISSION_LIFETIME;
    bool writeAddressRelations = false;
    bool writeAsciiFiles = false;
    bool writeMobilityFiles = false;
@@ -1838,14 +5369,23 @@ int main (int argc, char *argv[]) {
    CommandLine cmd;                                                                                             //---------------------------------------
    cmd.AddValue ("areaHeight", "The height (depth) of the simulation surface", areaHeight);                     //---------------------------------------
    cmd.AddValue ("areaWidth", "The width of the simulation surface", areaWidth);                                //---------------------------------------
+   cmd.AddValue ("denseForwarding", "Route the packets of the agents to the hosts of the OLSR routing table from a copy of the table indexed by node ID", denseForwarding);  //---------------------------------------
    cmd.AddValue ("endNodes", "Numero final de nodos", endNodes);                                                //---------------------------------------
    cmd.AddValue ("initNodes", "Numero inicial de nodos", initNodes);                                            //---------------------------------------
+   cmd.AddValue ("lazyOlsrDecoding", "Receive the OLSR packets in the agents, decoding only the messages that are processed or forwarded", lazyOlsrDecoding);  //---------------------------------------
+   cmd.AddValue ("minRecalculationInterval", "Minimum time between the recalculations requested by reservations", minRecalculationInterval);  //---------------------------------------
    cmd.AddValue ("nodeIncrement", "Incremento de nodos por simulacion", nodeIncrement);                         //---------------------------------------
    cmd.AddValue ("nSinks", "Number of sinks", nSinks);                                                          //---------------------------------------
+   cmd.AddValue ("olsrReceiver", "Receive the OLSR packets in the agents, computing the MPR set with bitsets", olsrReceiver);  //---------------------------------------
+   cmd.AddValue ("olsrRxTrace", "Fire the OLSR Rx trace from the agents that receive the OLSR packets (the messages are then all decoded, even with lazyOlsrDecoding)", olsrRxTrace);  //---------------------------------------
    cmd.AddValue ("port", "Communication port", port);                                                           //---------------------------------------
    cmd.AddValue ("recalculatePeriod", "Periodo de tiempo para actualizar las tablas", recalculatePeriod);       //---------------------------------------
+   cmd.AddValue ("recalculationThreads", "Threads that recalculate the routing tables in batch (0: one event per agent). In batch mode all the agents recalculate at the same time instead of in one slot each, and the requests within minRecalculationInterval are dropped instead of deferred", recalculationThreads);  //---------------------------------------
+   cmd.AddValue ("shareRelations", "Share the address relations of the nodes among the agents", shareRelations);  //---------------------------------------
    cmd.AddValue ("totalTime", "Tiempo total de la simulacion (en segundos)", totalTime);                        //---------------------------------------
    cmd.AddValue ("traceMobility", "Enable mobility tracing", traceMobility);                                    //---------------------------------------
+   cmd.AddValue ("transmissionCapacity", "Maximum number of destinations remembered by each agent (0: unbounded)", transmissionCapacity);  //---------------------------------------
+   cmd.AddValue ("transmissionLifetime", "Time a destination is remembered since its last packet (0: forever, no aging event)", transmissionLifetime);  //---------------------------------------
    cmd.AddValue ("writeAddressRelations", "Write address relations registry files", writeAddressRelations);     //---------------------------------------
    cmd.AddValue ("writeAsciiFiles", "Write packet information in ASCII format", writeAsciiFiles);               //---------------------------------------
    cmd.AddValue ("writeMobilityFiles", "Write mobility information", writeMobilityFiles);                       //---------------------------------------
@@ -1857,14 +5397,15 @@ int main (int argc, char *argv[]) {
    
    for (uint32_t i = initNodes;i <= endNodes;i += nodeIncrement) {
       NoriaSimulation caSimulation;     // Creacion del la simulacion con agentes
-      caSimulation.SetParameters (areaHeight, areaWidth, i, nSinks, true, recalculatePeriod, totalTime, traceMobility, writeAddressRelations, writeAsciiFiles, writeMobilityFiles, writePcapFiles, writeReservationState, writeReservedNodes, writeRoutingTables);    // Configuracion de los parametros de simulacion
+      caSimulation.SetParameters (areaHeight, areaWidth, i, nSinks, true, recalculatePeriod, totalTime, traceMobility, writeAddressRelations, writeAsciiFiles, writeMobilityFiles, writePcapFiles, writeReservationState, writeReservedNodes, writeRoutingTables, shareRelations, recalculationThreads, minRecalculationInterval, olsrReceiver, lazyOlsrDecoding, olsrRxTrace, denseForwarding, transmissionLifetime, transmissionCapacity);    // Configuracion de los parametros de simulacion
       caSimulation.Run ();              // Corrida de la simulacion
       
       NoriaSimulation saSimulation;     // Creacion del la simulacion sin agentes
-      saSimulation.SetParameters (areaHeight, areaWidth, i, nSinks, false, recalculatePeriod, totalTime, traceMobility, writeAddressRelations, writeAsciiFiles, writeMobilityFiles, writePcapFiles, writeReservationState, writeReservedNodes, writeRoutingTables);    // Configuracion de los parametros de simulacion
+      saSimulation.SetParameters (areaHeight, areaWidth, i, nSinks, false, recalculatePeriod, totalTime, traceMobility, writeAddressRelations, writeAsciiFiles, writeMobilityFiles, writePcapFiles, writeReservationState, writeReservedNodes, writeRoutingTables, shareRelations, recalculationThreads, minRecalculationInterval, olsrReceiver, lazyOlsrDecoding, olsrRxTrace, denseForwarding, transmissionLifetime, transmissionCapacity);    // Configuracion de los parametros de simulacion
       saSimulation.Run ();              // Corrida de la simulacion
    }
    
    return 0;    // Salida correcta del programa
 }
 
+#endif
@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+/**
+ * Checks that MprCalculator::Compute selects the same MPR set as
+ * RoutingProtocol::MprComputation. Random neighborhoods are written in the
+ * state of a protocol, and the MPR set of each one is computed both ways.
+ * The simulation is compiled with this file, without its main
+ */
+#define NORIA_TEST
+#include "../simulation.cc"
+
+/**
+ * Address of the node (0), of a neighbor or of a 2-hop neighbor
+ */
+static Ipv4Address GetAddress (uint32_t i) {
+   return Ipv4Address (0x0a000001 + i);
+}
+
+/**
+ * Writes a random neighborhood in the state of the protocol. The 2-hop
+ * neighbors include the node itself, neighbors and pairs of not symmetric or
+ * WILL_NEVER neighbors, which both computations must leave out
+ */
+static void FillNeighborhood (Ptr<olsr::RoutingProtocol> olsr, UniformVariable &random) {
+   OlsrState &state = olsr->m_state;
+   state = OlsrState ();
+   
+   uint32_t neighbors = random.GetInteger (0, 40);
+   uint32_t twoHops = random.GetInteger (0, 80);
+   for (uint32_t i = 1; i <= neighbors; i++) {
+      olsr::NeighborTuple neighbor;
+      neighbor.neighborMainAddr = GetAddress (i);
+      neighbor.status = (random.GetValue (0, 1) < 0.8) ? olsr::NeighborTuple::STATUS_SYM : olsr::NeighborTuple::STATUS_NOT_SYM;
+      neighbor.willingness = random.GetInteger (OLSR_WILL_NEVER, OLSR_WILL_ALWAYS);
+      state.InsertNeighborTuple (neighbor);
+      
+      uint32_t pairs = random.GetInteger (0, 12);
+      for (uint32_t j = 0; j < pairs; j++) {
+         olsr::TwoHopNeighborTuple twoHop;
+         twoHop.neighborMainAddr = neighbor.neighborMainAddr;
+         twoHop.twoHopNeighborAddr = GetAddress (random.GetInteger (0, neighbors + twoHops));
+         twoHop.expirationTime = Seconds (100);
+         state.InsertTwoHopNeighborTuple (twoHop);
+      }
+   }
+}
+
+/**
+ *
+ */
+int main (int argc, char *argv[]) {
+   uint32_t cases = 1000;
+   uint32_t seed = 1;
+   CommandLine cmd;
+   cmd.AddValue ("cases", "Number of random neighborhoods", cases);
+   cmd.AddValue ("seed", "Seed of the random neighborhoods", seed);
+   cmd.Parse (argc, argv);
+   
+   SeedManager::SetSeed (seed);
+   UniformVariable random;
+   Ptr<olsr::RoutingProtocol> olsr = CreateObject<olsr::RoutingProtocol> ();
+   olsr->m_mainAddress = GetAddress (0);
+   MprCalculator calculator;
+   
+   uint32_t failures = 0;
+   for (uint32_t i = 0; i < cases; i++) {
+      FillNeighborhood (olsr, random);
+      olsr->MprComputation ();
+      olsr::MprSet expected = olsr->m_state.GetMprSet ();
+      calculator.Compute (olsr);
+      if (olsr->m_state.GetMprSet () != expected) {
+         std::cout << "Neighborhood " << i << ": MprCalculator selected " << olsr->m_state.GetMprSet ().size () << " MPRs, MprComputation " << expected.size () << std::endl;
+         failures += 1;
+      }
+   }
+   std::cout << cases - failures << " of " << cases << " neighborhoods with the same MPR set" << std::endl;
+   
+   Simulator::Destroy ();
+   return (failures == 0) ? 0 : 1;
+}
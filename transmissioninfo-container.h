@@ -7,6 +7,9 @@
 #ifndef TRANSMISSIONINFO_CONTAINER_H
 #define TRANSMISSIONINFO_CONTAINER_H
 
+#include <functional>
+#include <queue>
+
 using namespace ns3;
 
 /**
@@ -47,7 +50,8 @@ class TransmissionInfoContainer {
    TransmissionInfoContainer ();
    
    /**
-    *
+    * Adds the transmission. If the container is full, the oldest
+    * transmission is removed to make room for it
     */
    void Add (Ipv4Address ip, double time);
    
@@ -61,11 +65,31 @@ class TransmissionInfoContainer {
     */
    bool Exist (Ipv4Address ip);
    
+   /**
+    * Removes the transmissions older than the lifetime
+    */
+   void Expire (double time);
+   
+   /**
+    *
+    */
+   uint32_t GetSize (void);
+   
    /**
     *
     */
    double GetTime (Ipv4Address ip);
    
+   /**
+    * Maximum number of transmissions kept (0: unbounded)
+    */
+   void SetCapacity (uint32_t capacity);
+   
+   /**
+    * Time (in seconds) a transmission is kept since its last packet (0: forever)
+    */
+   void SetLifetime (double lifetime);
+   
    /**
     *
     */
@@ -78,11 +102,47 @@ class TransmissionInfoContainer {
    
    private:
    
+   /**
+    * Entry of the age heap: time of the transmission and IP address
+    */
+   typedef std::pair<double, uint32_t> Age;
+   
+   /**
+    * Removes the oldest transmission
+    */
+   void EraseOldest (void);
+   
+   /**
+    * Removes the transmission in the position of the vector
+    */
+   void EraseAt (uint32_t index);
+   
    /**
     *
     */
    std::vector<TransmissionInfo> v_transmissions;
    
+   /**
+    * Position of each destination IP address in the vector
+    */
+   AddressIndex m_index;
+   
+   /**
+    * Transmissions ordered by time (the oldest at the top). An entry may be
+    * outdated if the transmission was updated or erased
+    */
+   std::priority_queue<Age, std::vector<Age>, std::greater<Age> > m_ages;
+   
+   /**
+    *
+    */
+   uint32_t m_capacity;
+   
+   /**
+    *
+    */
+   double m_lifetime;
+   
 };
 
 #endif
@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/**
+ * NORIA: Node Reservation Intelligent Agent
+ * Author: Andres Mauricio Bejarano Posada <abejarano@uninorte.edu.co>
+ */
+
+#ifndef TUPLE_SWEEPER_H
+#define TUPLE_SWEEPER_H
+
+#include "olsr-routing-protocol.h"
+#include "olsrtuple-index.h"
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Kinds of the tuples checked by the sweeper, one per timer of the protocol
+ */
+enum TupleKind {
+   TUPLE_DUPLICATE = 0, // DupTupleTimerExpire
+   TUPLE_LINK,          // LinkTupleTimerExpire
+   TUPLE_TWO_HOP,       // Nb2hopTupleTimerExpire
+   TUPLE_MPR_SELECTOR,  // MprSelTupleTimerExpire
+   TUPLE_TOPOLOGY,      // TopologyTupleTimerExpire
+   TUPLE_IFACE_ASSOC,   // IfaceAssocTupleTimerExpire
+   TUPLE_ASSOCIATION    // AssociationTupleTimerExpire
+};
+
+/**
+ * Struct where a pending check of the expiration of a tuple is stored
+ */
+struct TupleExpiry {
+
+   /**
+    * Time of the check
+    */
+   Time e_time;
+   
+   /**
+    * Order in which the check was added, so the checks of a same time are
+    * done in a fixed order
+    */
+   uint64_t e_order;
+   
+   /**
+    *
+    */
+   TupleKind e_kind;
+   
+   /**
+    * First address of the key of the tuple: D_addr, L_neighbor_iface_addr,
+    * N_neighbor_main_addr, MS_main_addr, T_dest_addr, I_iface_addr or
+    * A_gateway_addr
+    */
+   Ipv4Address e_address;
+   
+   /**
+    * Second address of the key of the tuple: N_2hop_addr, T_last_addr or
+    * A_network_addr
+    */
+   Ipv4Address e_secondAddress;
+   
+   /**
+    * A_netmask of the association tuple
+    */
+   Ipv4Mask e_mask;
+   
+   /**
+    * D_seq_num of the duplicate tuple
+    */
+   uint16_t e_sequenceNumber;
+   
+   /**
+    *
+    */
+   bool operator> (const TupleExpiry &other) const {
+      return e_time > other.e_time || (e_time == other.e_time && e_order > other.e_order);
+   }
+};
+
+
+/**
+ * Expires the tuples of a node from a single pending event, in place of the
+ * timer events the protocol schedules for each tuple. Each tuple is checked
+ * at the same time and with the same steps as its timer (1 microsecond after
+ * its expiration time): it is removed if it expired, and checked again later
+ * if it was refreshed. The tuples whose check falls at the same time are
+ * checked by the same event.
+ * Only the tuples added through the sweeper are checked by it; the tuples
+ * added by the protocol itself keep their own events
+ */
+class TupleSweeper {
+
+   public:
+   
+   /**
+    *
+    */
+   TupleSweeper (void);
+   
+   /**
+    * Checks the association tuple when it expires
+    */
+   void AddAssociation (Ipv4Address gatewayAddr, Ipv4Address networkAddr, Ipv4Mask netmask, Time expirationTime);
+   
+   /**
+    * Checks the duplicate tuple when it expires
+    */
+   void AddDuplicate (Ipv4Address address, uint16_t sequenceNumber, Time expirationTime);
+   
+   /**
+    * Checks the interface association tuple when it expires
+    */
+   void AddIfaceAssoc (Ipv4Address ifaceAddr, Time expirationTime);
+   
+   /**
+    * Checks the link tuple at the given time, the earliest of its L_time and
+    * L_SYM_time
+    */
+   void AddLink (Ipv4Address neighborIfaceAddr, Time checkTime);
+   
+   /**
+    * Checks the MPR selector tuple when it expires
+    */
+   void AddMprSelector (Ipv4Address mainAddr, Time expirationTime);
+   
+   /**
+    * Checks the topology tuple when it expires
+    */
+   void AddTopology (Ipv4Address destAddr, Ipv4Address lastAddr, Time expirationTime);
+   
+   /**
+    * Checks the 2-hop neighbor tuple when it expires
+    */
+   void AddTwoHop (Ipv4Address neighborMainAddr, Ipv4Address twoHopNeighborAddr, Time expirationTime);
+   
+   /**
+    * Checks done, one per timer event the protocol would have run
+    */
+   uint64_t GetChecks (void) const;
+   
+   /**
+    * Events run by the sweeper
+    */
+   uint64_t GetSweeps (void) const;
+   
+   /**
+    * The indexed tuples are found and removed through the given index. The
+    * neighbor loss of a link tuple whose L_SYM_time expired is done by the
+    * given callback, in place of RoutingProtocol::NeighborLoss
+    */
+   void Install (Ptr<olsr::RoutingProtocol> olsr, OlsrTupleIndex *index, Callback<void, const olsr::LinkTuple &> neighborLoss);
+   
+   
+   private:
+   
+   /**
+    * Adds the check and schedules the event if the check comes before it
+    */
+   void Add (TupleExpiry &expiry);
+   
+   /**
+    * Same steps as the timer of the tuple. Returns true if the tuple must be
+    * checked again, at the time left in the check
+    */
+   bool Check (TupleExpiry &expiry);
+   
+   /**
+    * Time of the check of a tuple, as the DELAY of the protocol
+    */
+   static Time GetCheckTime (Time expirationTime);
+   
+   /**
+    * Checks the tuples whose time came
+    */
+   void Sweep (void);
+   
+   /**
+    *
+    */
+   Ptr<olsr::RoutingProtocol> m_olsr;
+   
+   /**
+    * Index of the receiver the sweeper belongs to
+    */
+   OlsrTupleIndex *m_index;
+   
+   /**
+    *
+    */
+   Callback<void, const olsr::LinkTuple &> m_neighborLoss;
+   
+   /**
+    * Pending checks, the earliest first
+    */
+   std::priority_queue<TupleExpiry, std::vector<TupleExpiry>, std::greater<TupleExpiry> > m_checks;
+   
+   /**
+    * Number of checks added
+    */
+   uint64_t m_order;
+   
+   /**
+    *
+    */
+   uint64_t m_doneChecks;
+   
+   /**
+    *
+    */
+   uint64_t m_sweeps;
+   
+   /**
+    * Pending event of the sweeper
+    */
+   EventId m_event;
+   
+   /**
+    * Time of the pending event
+    */
+   Time m_eventTime;
+
+};
+
+#endif